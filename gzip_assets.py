@@ -0,0 +1,33 @@
+# Gzip the web assets before they are embedded in the firmware (see board_build.embed_files)
+
+import gzip
+import os
+
+Import("env")
+
+assets = [
+    "configuration.html",
+    "configuration.js",
+    "data.html",
+    "data.js",
+    "jquery.min.js",
+    "infos.html",
+    "infos.js",
+    "style.css",
+]
+
+directory = os.path.join(env["PROJECT_DIR"], "html")
+
+for asset in assets:
+    source = os.path.join(directory, asset)
+    target = source + ".gz"
+    if os.path.exists(target) and os.path.getmtime(target) >= os.path.getmtime(source):
+        continue
+
+    with open(source, "rb") as file:
+        content = file.read()
+    # mtime=0 keeps the output, and so the ETag, stable across builds
+    with open(target, "wb") as file:
+        file.write(gzip.compress(content, compresslevel=9, mtime=0))
+
+    print("gzip %s: %u -> %u bytes" % (asset, len(content), os.path.getsize(target)))
@@ -1,3 +1,20 @@
+const maxSensors = 16;
+
+const defaultSensor = {
+    enabled: true,
+    name: "",
+    driver: 1,
+    address: 72,
+    channel: 0,
+    type: 1,
+    min: 0,
+    max: 100,
+    calibration: { angular_coefficient: 0.000125, linear_coefficient: 0 },
+    alarm: { enabled: false, value: 25 }
+};
+
+var sensors = [];
+
 $(document).ready(() => {
     handleConfiguration();
 
@@ -5,6 +22,17 @@ $(document).ready(() => {
 });
 
 function handleConfiguration() {
+    $("#sensors_add").click(() => {
+        var rows = $("#sensors tbody tr");
+        if (rows.length < maxSensors) {
+            addSensor(rows.length, sensors.length > 0 ? sensors[sensors.length - 1] : defaultSensor);
+        }
+    });
+
+    $("#sensors_remove").click(() => {
+        $("#sensors tbody tr").last().remove();
+    });
+
     $("#sensors").submit((event) => {
         event.preventDefault();
         if ($("#sensors")[0].checkValidity()) {
@@ -39,6 +67,13 @@ function handleConfiguration() {
             setAutoSleepWakeUp().then(() => clearMessage());
         }
     });
+
+    $("#storage").submit((event) => {
+        event.preventDefault();
+        if ($("#storage")[0].checkValidity()) {
+            setStorage().then(() => clearMessage());
+        }
+    });
 }
 
 function setDateTime() {
@@ -80,12 +115,15 @@ function setSensors() {
         cfg.sensors.push({
             enabled: $(`#sensor_enabled_${i}`).prop("checked"),
             name: $(`#sensor_name_${i}`).prop("value"),
+            driver: parseInt($(`#sensor_driver_${i}`).prop("value")),
+            address: parseInt($(`#sensor_address_${i}`).prop("value")),
+            channel: parseInt($(`#sensor_channel_${i}`).prop("value")),
             type: parseInt($(`#sensor_type_${i}`).prop("value")),
             min: parseFloat($(`#sensor_min_${i}`).prop("value")),
             max: parseFloat($(`#sensor_max_${i}`).prop("value")),
             calibration: {
-                factor: parseFloat($(`#sensor_calibration_angular_coefficient_${i}`).prop("value")),
-                offset: parseFloat($(`#sensor_calibration_linear_coefficient_${i}`).prop("value"))
+                angular_coefficient: parseFloat($(`#sensor_calibration_angular_coefficient_${i}`).prop("value")),
+                linear_coefficient: parseFloat($(`#sensor_calibration_linear_coefficient_${i}`).prop("value"))
             },
             alarm: {
                 enabled: $(`#sensor_alarm_enabled_${i}`).prop("checked"),
@@ -97,6 +135,32 @@ function setSensors() {
     return setConfiguration(cfg);
 }
 
+function addSensor(i, s) {
+    var row = $($.parseHTML($("#sensor_template").html()));
+    row.find("#sensor_number").text(i + 1);
+    row.find("#sensor_enabled").prop("checked", s.enabled);
+    row.find("#sensor_name").prop("value", s.name);
+    row.find("#sensor_driver").prop("value", s.driver);
+    row.find("#sensor_address").prop("value", s.address);
+    row.find("#sensor_channel").prop("value", s.channel);
+    row.find("#sensor_type").prop("value", s.type);
+    row.find("#sensor_min").prop("value", s.min);
+    row.find("#sensor_max").prop("value", s.max);
+    row.find("#sensor_calibration_angular_coefficient").prop("value", s.calibration.angular_coefficient);
+    row.find("#sensor_calibration_linear_coefficient").prop("value", s.calibration.linear_coefficient);
+    row.find("#sensor_alarm_enabled").prop("checked", s.alarm.enabled);
+    row.find("#sensor_alarm_value").prop("value", s.alarm.value);
+    for (var c of row.find("*")) {
+        if (c.id) {
+            c.id += `_${i}`;
+        }
+        if (c.htmlFor) {
+            c.htmlFor += `_${i}`;
+        }
+    }
+    row.appendTo($("#sensors table tbody"));
+}
+
 function setAccessPoint() {
     var cfg = {
         access_point: {
@@ -135,7 +199,19 @@ function setAutoSleepWakeUp() {
         auto_sleep_wakeup: {
             enabled: $("#auto_sleep_wakeup_enabled").prop("checked"),
             sleep_time: $("#auto_sleep_wakeup_sleep_time").prop("value").split(":").map((s) => parseInt(s, 10)),
-            wakeup_time: $("#auto_sleep_wakeup_wakeup_time").prop("value").split(":").map((s) => parseInt(s, 10))
+            wakeup_time: $("#auto_sleep_wakeup_wakeup_time").prop("value").split(":").map((s) => parseInt(s, 10)),
+            log_interval: parseInt($("#auto_sleep_wakeup_log_interval").prop("value"), 10)
+        }
+    };
+    return setConfiguration(cfg);
+}
+
+function setStorage() {
+    var cfg = {
+        storage: {
+            engine: parseInt($("#storage_engine").prop("value"), 10),
+            batch_size: parseInt($("#storage_batch_size").prop("value"), 10),
+            batch_age: parseInt($("#storage_batch_age").prop("value"), 10)
         }
     };
     return setConfiguration(cfg);
@@ -204,29 +280,16 @@ function getConfiguration() {
             $("#auto_sleep_wakeup_enabled").prop("checked", cfg.auto_sleep_wakeup.enabled);
             $("#auto_sleep_wakeup_sleep_time").prop("value", cfg.auto_sleep_wakeup.sleep_time.map((n) => n.toString(10).padStart(2, "0")).join(":"));
             $("#auto_sleep_wakeup_wakeup_time").prop("value", cfg.auto_sleep_wakeup.wakeup_time.map((n) => n.toString(10).padStart(2, "0")).join(":"));
+            $("#auto_sleep_wakeup_log_interval").prop("value", cfg.auto_sleep_wakeup.log_interval);
+
+            $("#storage_engine").prop("value", cfg.storage.engine);
+            $("#storage_batch_size").prop("value", cfg.storage.batch_size);
+            $("#storage_batch_age").prop("value", cfg.storage.batch_age);
 
-            var template = $($.parseHTML($("#sensor_template").html()));
+            sensors = cfg.sensors;
+            $("#sensors tbody tr").remove();
             for (const [i, s] of cfg.sensors.entries()) {
-                var row = template.clone();
-                row.find("#sensor_number").text(i + 1);
-                row.find("#sensor_enabled").prop("checked", s.enabled);
-                row.find("#sensor_name").prop("value", s.name);
-                row.find("#sensor_type").prop("value", s.type);
-                row.find("#sensor_min").prop("value", s.min);
-                row.find("#sensor_max").prop("value", s.max);
-                row.find("#sensor_calibration_angular_coefficient").prop("value", s.calibration.angular_coefficient);
-                row.find("#sensor_calibration_linear_coefficient").prop("value", s.calibration.linear_coefficient);
-                row.find("#sensor_alarm_enabled").prop("checked", s.alarm.enabled);
-                row.find("#sensor_alarm_value").prop("value", s.alarm.value);
-                for (var c of row.find("*")) {
-                    if (c.id) {
-                        c.id += `_${i}`;
-                    }
-                    if (c.htmlFor) {
-                        c.htmlFor += `_${i}`;
-                    }
-                }
-                row.appendTo($("#sensors table tbody"));
+                addSensor(i, s);
             }
             successMessage("Done");
             deferred.resolve();
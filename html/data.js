@@ -1,3 +1,5 @@
+const pageSize = 20;
+
 $(document).ready(() => {
     handleFilter();
     getDateTime().done(() => handleLoadMore());
@@ -39,7 +41,7 @@ function handleLoadMore(withoutFilter) {
 
     getData(withoutFilter ? null : buildfilter())
         .done((count) => {
-            if (count == 20) {
+            if (count == pageSize) {
                 $(window).scroll(() => {
                     if ($(window).height() + $(window).scrollTop() > $("body").height() * 0.75) {
                         $(window).unbind("scroll");
@@ -124,27 +126,41 @@ function getData(filter) {
             filter = this.prevFilter;
         }
     }
+    else {
+        delete this.prevCursor;
+    }
+
+    var params = Object.assign({ limit: pageSize }, filter);
+    if (typeof this.prevCursor != "undefined") {
+        params.cursor = this.prevCursor;
+    }
 
     $.ajax({
         type: "GET",
         url: "/data.json",
         accepts: 'application/json',
         timeout: 5000,
-        data: filter,
+        data: params,
         beforeSend: () => {
             $("#filter :input").prop("disabled", true);
             infoMessage("Loading");
         }
     })
-        .done((data) => {
+        .done((page) => {
             if (clear) {
                 $("#result tbody tr").remove();
             }
 
-            let lastId = null;
+            // One column per configured sensor, the count comes with the data
+            if (page.data.length > 0) {
+                $("#result thead th.sensor").remove();
+                for (const n of page.data[0].sensors.keys()) {
+                    $(`<th class="sensor"> Sensor ${n + 1} (kPa) </th>`).appendTo($("#result thead tr"));
+                }
+            }
 
             let template = $($.parseHTML($("#data_template").html()));
-            for (const [i, d] of data.entries()) {
+            for (const [i, d] of page.data.entries()) {
                 let row = template.clone();
                 let [date, time] = d.datetime.split(" ");
                 row.find("#data_id").text(d.id);
@@ -153,9 +169,10 @@ function getData(filter) {
                 row.find("#data_temperature").text(d.temperature);
                 row.find("#data_humidity").text(d.humidity);
                 row.find("#data_pressure").text(d.pressure);
-                row.find("#data_sensor_0").text(d.sensors[0]);
-                row.find("#data_sensor_1").text(d.sensors[1]);
-                row.find("#data_sensor_2").text(d.sensors[2]);
+                for (const [n, value] of d.sensors.entries()) {
+                    $(`<td> <label for="data_sensor_${n}"> Sensor ${n + 1} (kPa) </label> </td>`).appendTo(row);
+                    $(`<td> <span id="data_sensor_${n}"></span> </td>`).appendTo(row).find("span").text(value);
+                }
                 for (let c of row.find("*")) {
                     if (c.id) {
                         c.id += `_${i}`;
@@ -165,21 +182,15 @@ function getData(filter) {
                     }
                 }
                 row.appendTo($("#result tbody"));
-                lastId = Math.max(lastId, d.id);
             }
 
             this.prevFilter = filter;
-            if (lastId != null) {
-                if (this.prevFilter != null) {
-                    this.prevFilter.id = lastId + 1;
-                }
-                else {
-                    this.prevFilter = { id: lastId + 1 };
-                }
+            if (page.cursor) {
+                this.prevCursor = page.cursor;
             }
 
             successMessage("Done");
-            deferred.resolve(data.length);
+            deferred.resolve(page.data.length);
         })
         .fail((xhr, status, error) => {
             errorMessage(status == "timeout" ? "Fail: Timeout" : `Fail: ${xhr.status} ${xhr.statusText}`);
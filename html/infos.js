@@ -1,8 +1,24 @@
 $(document).ready(() => {
     updateInfos(true);
-    setInterval(updateInfos, 5000);
+    if (typeof window.EventSource != "undefined") {
+        subscribeInfos();
+    }
+    else {
+        setInterval(updateInfos, 5000);
+    }
 });
 
+function subscribeInfos() {
+    var source = new EventSource("/events");
+    source.addEventListener("infos", (event) => {
+        var info = JSON.parse(event.data);
+        showInfos(info);
+        drawGraphs(info);
+    });
+    source.onopen = () => clearMessage();
+    source.onerror = () => warningMessage("Reconnecting");
+}
+
 function updateInfos(first) {
     first ? infoMessage("Loading") : null;
     getInfos()
@@ -34,34 +50,7 @@ function getInfos() {
         timeout: 5000
     })
         .done((info) => {
-            $("#values tbody tr").remove();
-
-            if (!info.temperature || !info.humidity || !info.pressure) {
-                $("#temperature").prop("class", "error").text("ERROR");
-                $("#humidity").prop("class", "error").text("ERROR");
-                $("#pressure").prop("class", "error").text("ERROR");
-            }
-            else {
-                $("#temperature").removeProp("class").text(info.temperature);
-                $("#humidity").removeProp("class").text(info.humidity);
-                $("#pressure").removeProp("class").text(info.pressure);
-            }
-
-            var template = $($.parseHTML($("#sensor_template").html()));
-            for (const [i, sensor] of info.sensors.entries()) {
-                var row = template.clone();
-                row.find("#sensor_name").text(sensor.name);
-                row.find("#sensor_value").text(sensor.value);
-                for (let c of row.find("*")) {
-                    if (c.id) {
-                        c.id += `_${i}`;
-                    }
-                    if (c.htmlFor) {
-                        c.htmlFor += `_${i}`;
-                    }
-                }
-                row.appendTo($("#values tbody"));
-            }
+            showInfos(info);
             deferred.resolve(info);
         })
         .fail((xhr, status, error) => {
@@ -70,6 +59,82 @@ function getInfos() {
     return deferred.promise();
 }
 
+function showInfos(info) {
+    $("#values tbody tr").remove();
+
+    if (!info.temperature || !info.humidity || !info.pressure) {
+        $("#temperature").prop("class", "error").text("ERROR");
+        $("#humidity").prop("class", "error").text("ERROR");
+        $("#pressure").prop("class", "error").text("ERROR");
+    }
+    else {
+        $("#temperature").removeProp("class").text(info.temperature);
+        $("#humidity").removeProp("class").text(info.humidity);
+        $("#pressure").removeProp("class").text(info.pressure);
+    }
+
+    $("#storage_queue").text(`${info.storage.queue_depth} / ${info.storage.queue_capacity}`);
+    $("#storage_queue_high_water").text(info.storage.queue_high_water);
+    $("#storage_dropped").prop("class", info.storage.dropped > 0 ? "warning" : "").text(info.storage.dropped);
+    $("#storage_flushes").text(info.storage.flushes);
+
+    $("#bus tbody tr").remove();
+    var busTemplate = $($.parseHTML($("#bus_template").html()));
+    for (const device of ["bme280", "ds3231", "lcd", "ads1115"]) {
+        var counters = info.bus[device];
+        var busRow = busTemplate.clone();
+        busRow.find("#bus_device").text(device.toUpperCase());
+        busRow.find("#bus_transactions").text(counters.transactions);
+        busRow.find("#bus_errors").prop("class", counters.errors > 0 ? "warning" : "").text(counters.errors);
+        busRow.find("#bus_latency_last").text(counters.latency_last);
+        busRow.find("#bus_latency_max").text(counters.latency_max);
+        for (let c of busRow.find("*")) {
+            if (c.id) {
+                c.id += `_${device}`;
+            }
+            if (c.htmlFor) {
+                c.htmlFor += `_${device}`;
+            }
+        }
+        busRow.appendTo($("#bus tbody"));
+    }
+
+    $("#boot tbody tr").remove();
+    var bootTemplate = $($.parseHTML($("#boot_template").html()));
+    var bootRows = info.boot.stages.concat([{ name: "first reading", done: true, start: info.boot.first_reading, duration: 0 }]);
+    for (const [i, stage] of bootRows.entries()) {
+        var bootRow = bootTemplate.clone();
+        bootRow.find("#boot_stage").text(stage.name);
+        bootRow.find("#boot_start").text(stage.done ? stage.start.toFixed(1) : "-");
+        bootRow.find("#boot_duration").text(stage.done ? stage.duration.toFixed(1) : "-");
+        for (let c of bootRow.find("*")) {
+            if (c.id) {
+                c.id += `_${i}`;
+            }
+            if (c.htmlFor) {
+                c.htmlFor += `_${i}`;
+            }
+        }
+        bootRow.appendTo($("#boot tbody"));
+    }
+
+    var template = $($.parseHTML($("#sensor_template").html()));
+    for (const [i, sensor] of info.sensors.entries()) {
+        var row = template.clone();
+        row.find("#sensor_name").text(sensor.name);
+        row.find("#sensor_value").text(sensor.value);
+        for (let c of row.find("*")) {
+            if (c.id) {
+                c.id += `_${i}`;
+            }
+            if (c.htmlFor) {
+                c.htmlFor += `_${i}`;
+            }
+        }
+        row.appendTo($("#values tbody"));
+    }
+}
+
 function clearMessage() {
     if (typeof this.fadeOutHandle != "undefined") {
         clearTimeout(this.fadeOutHandle);
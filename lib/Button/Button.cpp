@@ -1,4 +1,6 @@
 #include <Arduino.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
 
 #include "Button.hpp"
 
@@ -12,11 +14,63 @@ auto Button::init() -> void
     lastState = digitalRead( pin );
 }
 
+auto Button::initInterrupt() -> void
+{
+    init();
+    interruptMode = true;
+    attachInterruptArg( pin, Button::onEdge, this, CHANGE );
+}
+
+// The GPIO interrupt is allocated in IRAM and keeps firing while the flash cache is off for NVS or SD writes,
+// so the handler reads the input registers itself rather than calling digitalRead() from flash
+static auto IRAM_ATTR readPin( uint8_t pin ) -> uint8_t
+{
+    if ( pin < 32 )
+    {
+        return ( REG_READ( GPIO_IN_REG ) >> pin ) & 0x1;
+    }
+    return ( REG_READ( GPIO_IN1_REG ) >> ( pin - 32 ) ) & 0x1;
+}
+
+// millis() is IRAM resident in the core and the queue operations are forced inline
+auto IRAM_ATTR Button::onEdge( void* arg ) -> void
+{
+    auto button{static_cast<Button*>( arg )};
+    if ( not button->edges.push( Edge{static_cast<uint32_t>( millis() ), readPin( button->pin )} ) )
+    {
+        button->edgesLost.store( true, std::memory_order_relaxed );
+    }
+}
+
 auto Button::process() -> void
 {
+    if ( not interruptMode )
+    {
+        update( digitalRead( pin ), millis() );
+        return;
+    }
+
+    Edge edge;
+    while ( edges.pop( &edge ) )
+    {
+        // Whatever the held state reached before the edge counts first, e.g. a long press released since
+        update( lastState, edge.time );
+        update( edge.state, edge.time );
+    }
+
     const auto now{millis()};
+    if ( edgesLost.exchange( false, std::memory_order_relaxed ) )
+    {
+        update( digitalRead( pin ), now );
+    }
+    else
+    {
+        update( lastState, now );
+    }
+}
 
-    const auto currentState{digitalRead( pin )};
+auto Button::update( uint8_t currentState, uint32_t now ) -> void
+{
     if ( currentState != lastState )
     {
         if ( currentState == activeLogic )
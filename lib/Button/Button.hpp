@@ -5,17 +5,32 @@
 #include <vector>
 #include <functional>
 #include <cstdint>
+#include <atomic>
+
+#include <SpscQueue.hpp>
 
 class Button
 {
     public:
         Button( uint8_t pin, uint8_t activeLogic = LOW, uint8_t mode = INPUT_PULLUP, uint32_t debounceInterval = 30 );
         auto init() -> void;
+        // Timestamps edges from a GPIO interrupt instead of sampling the pin, process() then replays them
+        // so presses are timed right however late it runs
+        auto initInterrupt() -> void;
         auto process() -> void;
         auto onPress( std::function<void()> pressCallback, std::function<void()> releaseCallback = nullptr ) -> void;
         auto onPress( uint32_t pressInterval, std::function<void()> pressCallback, std::function<void()> releaseCallback = nullptr ) -> void;
         auto onPress( uint32_t pressInterval, uint8_t multiPress, std::function<void()> pressCallback, std::function<void()> releaseCallback = nullptr ) -> void;
     private:
+        struct Edge
+        {
+            uint32_t time;
+            uint8_t state;
+        };
+
+        static auto onEdge( void* arg ) -> void;
+        auto update( uint8_t currentState, uint32_t now ) -> void;
+
         uint8_t pin;
         uint8_t activeLogic;
         uint8_t mode;
@@ -35,4 +50,8 @@ class Button
 
         uint32_t pressTimer{0};
         std::vector<Press> presses{};
+
+        bool interruptMode{false};
+        SpscQueue<Edge, 32> edges{};
+        std::atomic<bool> edgesLost{false};
 };
\ No newline at end of file
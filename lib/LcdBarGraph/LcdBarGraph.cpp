@@ -6,6 +6,7 @@
 #include <cstdint>
 
 #include "LcdBarGraph.hpp"
+#include "LcdGlyphCache.hpp"
 
 namespace Characters
 {
@@ -70,30 +71,68 @@ namespace Characters
         0b00000};
 } // namespace Characters
 
-LcdBarGraph::LcdBarGraph(LCD *lcd, uint8_t startSlot, uint8_t middleSlot, uint8_t endSlot)
+LcdBarGraph::LcdBarGraph(LCD *lcd, LcdGlyphCache *glyphs)
 {
     this->lcd = lcd;
-    this->startSlot = startSlot;
-    this->middleSlot = middleSlot;
-    this->endSlot = endSlot;
+    this->glyphs = glyphs;
+    this->startSlot = ' ';
+    this->middleSlot = ' ';
+    this->endSlot = ' ';
+    this->held.fill(noSlot);
 }
 
 auto LcdBarGraph::init() -> void
 {
     uint8_t customChar[8];
 
+    // The frame glyphs are drawn by every bar and stay held for good
     memcpy_P(customChar, Characters::start, sizeof(customChar));
-    lcd->createChar(startSlot, customChar);
+    glyphs->acquire(customChar, &startSlot);
 
     memcpy_P(customChar, Characters::middle, sizeof(customChar));
-    lcd->createChar(middleSlot, customChar);
+    glyphs->acquire(customChar, &middleSlot);
 
     memcpy_P(customChar, Characters::end, sizeof(customChar));
-    lcd->createChar(endSlot, customChar);
+    glyphs->acquire(customChar, &endSlot);
 }
 
-auto LcdBarGraph::draw(uint8_t slot, int16_t posCol, int16_t posRow, int16_t barLength, double percent) -> void
+auto LcdBarGraph::release(uint8_t bar) -> void
 {
+    if (held[bar] != noSlot)
+    {
+        glyphs->release(held[bar]);
+        held[bar] = noSlot;
+    }
+}
+
+auto LcdBarGraph::writeGlyph(uint8_t bar, int16_t posCol, int16_t posRow, const uint8_t *pattern, uint8_t fallback) -> void
+{
+    uint8_t slot;
+    const auto acquired{glyphs->acquire(pattern, &slot)};
+
+    // Defining a glyph moves the address counter into CGRAM
+    lcd->setCursor(posCol, posRow);
+    if (acquired)
+    {
+        held[bar] = slot;
+        lcd->write(slot);
+    }
+    else
+    { //Every slot is held by another bar, draw the cell without its partial fill
+        lcd->write(fallback);
+    }
+}
+
+auto LcdBarGraph::draw(uint8_t bar, int16_t posCol, int16_t posRow, int16_t barLength, double percent) -> void
+{
+    if (bar >= maxBars)
+    {
+        return;
+    }
+
+    // The previous glyph stays in CGRAM until evicted, so redrawing the same value reuses it
+    release(bar);
+
     if (barLength == 0)
     {
         return;
@@ -114,9 +153,7 @@ auto LcdBarGraph::draw(uint8_t slot, int16_t posCol, int16_t posRow, int16_t bar
                 uint8_t customChar[8];
                 memcpy_P(customChar, Characters::single, sizeof(customChar));
 
-                lcd->createChar(slot, customChar);
-                lcd->setCursor(posCol + n, posRow);
-                lcd->write(static_cast<uint8_t>(slot));
+                writeGlyph(bar, posCol + n, posRow, customChar, ' ');
             }
             else if (n == 0)
             {
@@ -140,9 +177,7 @@ auto LcdBarGraph::draw(uint8_t slot, int16_t posCol, int16_t posRow, int16_t bar
                 uint8_t customChar[8];
                 memcpy_P(customChar, Characters::overflow, sizeof(customChar));
 
-                lcd->createChar(slot, customChar);
-                lcd->setCursor(posCol + n, posRow);
-                lcd->write(static_cast<uint8_t>(slot));
+                writeGlyph(bar, posCol + n, posRow, customChar, 0xFF);
             }
             else
             {
@@ -156,29 +191,32 @@ auto LcdBarGraph::draw(uint8_t slot, int16_t posCol, int16_t posRow, int16_t bar
             uint8_t customChar[8];
             memcpy_P(customChar, Characters::underflow, sizeof(customChar));
 
-            lcd->createChar(slot, customChar);
-            lcd->setCursor(posCol + n, posRow);
-            lcd->write(static_cast<uint8_t>(slot));
+            writeGlyph(bar, posCol + n, posRow, customChar, startSlot);
         }
         else
         {
             uint8_t customChar[8];
+            uint8_t fallback;
 
             if (n == 0 && n == barLength - 1)
             {
                 memcpy_P(customChar, Characters::single, sizeof(customChar));
+                fallback = ' ';
             }
             else if (n == 0)
             {
                 memcpy_P(customChar, Characters::start, sizeof(customChar));
+                fallback = startSlot;
             }
             else if (n == barLength - 1)
             {
                 memcpy_P(customChar, Characters::end, sizeof(customChar));
+                fallback = endSlot;
             }
             else
             {
                 memcpy_P(customChar, Characters::middle, sizeof(customChar));
+                fallback = middleSlot;
             }
 
             for (uint8_t nCharCol{n == 0 ? 1 : 0}; nCharCol < (n == barLength - 1 ? 4 : 5); ++nCharCol)
@@ -194,9 +232,7 @@ auto LcdBarGraph::draw(uint8_t slot, int16_t posCol, int16_t posRow, int16_t bar
                 barColumns--;
             }
 
-            lcd->createChar(slot, customChar);
-            lcd->setCursor(posCol + n, posRow);
-            lcd->write(static_cast<uint8_t>(slot));
+            writeGlyph(bar, posCol + n, posRow, customChar, fallback);
         }
     }
 }
\ No newline at end of file
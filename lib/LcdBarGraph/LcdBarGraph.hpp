@@ -2,16 +2,29 @@
 
 #include <Arduino.h>
 #include <LiquidCrystal.h>
+#include <array>
+
+#include "LcdGlyphCache.hpp"
 
 class LcdBarGraph
 {
 public:
-    LcdBarGraph(LCD* lcd, uint8_t startSlot, uint8_t middleSlot, uint8_t endSlot);
+    // Each bar holds at most one custom glyph at a time, so bars with equal partial cells share it
+    static constexpr uint8_t maxBars{LcdGlyphCache::slotsCount};
+
+    LcdBarGraph(LCD* lcd, LcdGlyphCache* glyphs);
 
     auto init() -> void;
-    auto draw(uint8_t slot, int16_t posCol, int16_t posRow, int16_t barLength, double percent) -> void;
+    auto draw(uint8_t bar, int16_t posCol, int16_t posRow, int16_t barLength, double percent) -> void;
 
 private:
+    static constexpr uint8_t noSlot{0xFF};
+
+    auto release(uint8_t bar) -> void;
+    auto writeGlyph(uint8_t bar, int16_t posCol, int16_t posRow, const uint8_t* pattern, uint8_t fallback) -> void;
+
     LCD *lcd;
+    LcdGlyphCache *glyphs;
     uint8_t startSlot, middleSlot, endSlot;
+    std::array<uint8_t, maxBars> held;
 };
\ No newline at end of file
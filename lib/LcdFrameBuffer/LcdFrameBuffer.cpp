@@ -0,0 +1,148 @@
+#include <Arduino.h>
+
+#include <LCD.h>
+#include <algorithm>
+#include <cstring>
+
+#include "LcdFrameBuffer.hpp"
+
+LcdFrameBuffer::LcdFrameBuffer()
+    : drawn{},
+      shown{},
+      valid{false},
+      memory{Memory::DDRAM},
+      address{0}
+{
+    this->drawn.ddram.fill( ' ' );
+}
+
+void LcdFrameBuffer::begin( uint8_t cols, uint8_t rows, uint8_t charsize )
+{
+    // Only the geometry matters, setCursor() maps rows with it
+    this->_cols = cols;
+    this->_numlines = rows;
+    this->_displayfunction = rows > 1 ? LCD_2LINE : LCD_1LINE;
+}
+
+void LcdFrameBuffer::send( uint8_t value, uint8_t mode )
+{
+    if ( mode == COMMAND )
+    {
+        if ( value & LCD_SETDDRAMADDR )
+        {
+            this->memory = Memory::DDRAM;
+            this->address = value & 0x7F;
+        }
+        else if ( value & LCD_SETCGRAMADDR )
+        {
+            this->memory = Memory::CGRAM;
+            this->address = value & 0x3F;
+        }
+        else if ( value == LCD_CLEARDISPLAY )
+        {
+            this->drawn.ddram.fill( ' ' );
+            this->memory = Memory::DDRAM;
+            this->address = 0;
+        }
+        else if ( ( value & ~0x01 ) == LCD_RETURNHOME )
+        {
+            this->memory = Memory::DDRAM;
+            this->address = 0;
+        }
+        return;
+    }
+
+    if ( this->memory == Memory::CGRAM )
+    {
+        this->drawn.cgram[this->address] = value;
+        this->address = ( this->address + 1 ) & 0x3F;
+    }
+    else
+    {
+        this->drawn.ddram[this->address] = value;
+        // Two line mode: 0x00..0x27 then 0x40..0x67, wrapping back to the first line
+        this->address = this->address == 0x27 ? 0x40 : this->address == 0x67 ? 0x00 : ( this->address + 1 ) & 0x7F;
+    }
+}
+
+auto LcdFrameBuffer::flush( LCD* target ) -> size_t
+{
+    auto sent{this->flushGlyphs( target )};
+    for ( uint8_t row{0}; row < this->_numlines; ++row )
+    {
+        sent += this->flushRow( target, row );
+    }
+    this->valid = true;
+    return sent;
+}
+
+auto LcdFrameBuffer::flush( LCD* target, uint8_t row ) -> size_t
+{
+    // Glyphs go first, the cells of this row may already point at a redefined slot
+    return this->flushGlyphs( target ) + this->flushRow( target, row );
+}
+
+auto LcdFrameBuffer::invalidate() -> void
+{
+    this->valid = false;
+}
+
+// Same row offsets as LCD::setCursor()
+auto LcdFrameBuffer::rowAddress( uint8_t row ) const -> uint8_t
+{
+    static constexpr uint8_t offsets[]{0x00, 0x40, 0x14, 0x54};
+    static constexpr uint8_t offsetsLarge[]{0x00, 0x40, 0x10, 0x50};
+
+    row = std::min<uint8_t>( row, this->_numlines - 1 );
+    return this->_cols == 16 and this->_numlines == 4 ? offsetsLarge[row] : offsets[row];
+}
+
+auto LcdFrameBuffer::flushGlyphs( LCD* target ) -> size_t
+{
+    auto sent{size_t{0}};
+    for ( uint8_t slot{0}; slot < 8; ++slot )
+    {
+        const auto glyph{this->drawn.cgram.data() + slot * 8};
+        if ( this->valid and std::memcmp( glyph, this->shown.cgram.data() + slot * 8, 8 ) == 0 )
+        {
+            continue;
+        }
+        target->createChar( slot, const_cast<uint8_t*>( glyph ) );
+        std::memcpy( this->shown.cgram.data() + slot * 8, glyph, 8 );
+        sent += 1 + 8;
+    }
+    return sent;
+}
+
+auto LcdFrameBuffer::flushRow( LCD* target, uint8_t row ) -> size_t
+{
+    const auto first{this->rowAddress( row )};
+
+    auto sent{size_t{0}};
+    auto cursor{-1};
+    for ( uint8_t col{0}; col < this->_cols; ++col )
+    {
+        const auto cell{first + col};
+        if ( this->valid and this->drawn.ddram[cell] == this->shown.ddram[cell] )
+        {
+            continue;
+        }
+
+        // A cursor move costs one byte, so a single clean cell in between is cheaper to rewrite than to skip
+        if ( cursor == col - 1 and col > 0 )
+        {
+            target->write( this->drawn.ddram[cell - 1] );
+            sent++;
+        }
+        else if ( cursor != col )
+        {
+            target->setCursor( col, row );
+            sent++;
+        }
+        target->write( this->drawn.ddram[cell] );
+        this->shown.ddram[cell] = this->drawn.ddram[cell];
+        sent++;
+        cursor = col + 1;
+    }
+    return sent;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LCD.h>
+
+#include <array>
+#include <cstdint>
+
+// In RAM copy of an HD44780: drawing decodes the command and data bytes into DDRAM and CGRAM shadows,
+// flush() then sends a real display only what differs from what it was last sent
+class LcdFrameBuffer : public LCD
+{
+    public:
+        LcdFrameBuffer();
+
+        void begin( uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS ) override;
+        void send( uint8_t value, uint8_t mode ) override;
+
+        // Both return the number of bytes sent to target
+        auto flush( LCD* target ) -> size_t;
+        auto flush( LCD* target, uint8_t row ) -> size_t;
+        // Forces the next flush to resend everything, e.g. after the display was reset
+        auto invalidate() -> void;
+
+    private:
+        enum Memory
+        {
+            DDRAM,
+            CGRAM
+        };
+
+        struct Screen
+        {
+            std::array<uint8_t, 0x80> ddram;
+            std::array<uint8_t, 0x40> cgram;
+        };
+
+        Screen drawn;
+        Screen shown;
+        bool valid;
+        Memory memory;
+        uint8_t address;
+
+        auto rowAddress( uint8_t row ) const -> uint8_t;
+        auto flushGlyphs( LCD* target ) -> size_t;
+        auto flushRow( LCD* target, uint8_t row ) -> size_t;
+};
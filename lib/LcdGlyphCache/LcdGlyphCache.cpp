@@ -0,0 +1,69 @@
+#include <Arduino.h>
+
+#include "LcdGlyphCache.hpp"
+
+LcdGlyphCache::LcdGlyphCache( LCD* lcd ) :
+    lcd{lcd},
+    slots{},
+    clock{0}
+{
+}
+
+auto LcdGlyphCache::acquire( const uint8_t* pattern, uint8_t* slot ) -> bool
+{
+    const auto patternKey{key( pattern )};
+
+    auto victim{slotsCount};
+    for ( uint8_t n{0}; n < slotsCount; ++n )
+    {
+        if ( slots[n].defined and slots[n].key == patternKey )
+        {
+            slots[n].references++;
+            slots[n].lastUse = ++clock;
+            *slot = n;
+            return true;
+        }
+
+        if ( slots[n].references > 0 )
+        {
+            continue;
+        }
+        // Never defined slots first, then the least recently used one
+        if ( victim == slotsCount or
+                ( slots[victim].defined and ( not slots[n].defined or slots[n].lastUse < slots[victim].lastUse ) ) )
+        {
+            victim = n;
+        }
+    }
+
+    if ( victim == slotsCount )
+    {
+        return false;
+    }
+
+    uint8_t customChar[8];
+    memcpy( customChar, pattern, sizeof( customChar ) );
+    lcd->createChar( victim, customChar );
+
+    slots[victim] = {patternKey, ++clock, 1, true};
+    *slot = victim;
+    return true;
+}
+
+auto LcdGlyphCache::release( uint8_t slot ) -> void
+{
+    if ( slot < slotsCount and slots[slot].references > 0 )
+    {
+        slots[slot].references--;
+    }
+}
+
+auto LcdGlyphCache::key( const uint8_t* pattern ) -> uint64_t
+{
+    uint64_t value{0};
+    for ( uint8_t n{0}; n < 8; ++n )
+    {
+        value = ( value << 5 ) | ( pattern[n] & 0b11111 );
+    }
+    return value;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LCD.h>
+
+#include <array>
+#include <cstdint>
+
+// Owns the 8 CGRAM slots of an HD44780: glyphs are looked up by content, so identical patterns share a slot,
+// and a new pattern replaces the least recently used slot nobody holds anymore
+class LcdGlyphCache
+{
+    public:
+        static constexpr uint8_t slotsCount{8};
+
+        explicit LcdGlyphCache( LCD* lcd );
+
+        // On success the slot holds pattern and is referenced until release(); fails when every slot is held
+        auto acquire( const uint8_t* pattern, uint8_t* slot ) -> bool;
+        auto release( uint8_t slot ) -> void;
+
+    private:
+        struct Slot
+        {
+            uint64_t key;
+            uint32_t lastUse;
+            uint8_t references;
+            bool defined;
+        };
+
+        // A 5x8 glyph packs losslessly into 40 bits, so the key doubles as an exact comparison
+        static auto key( const uint8_t* pattern ) -> uint64_t;
+
+        LCD* lcd;
+        std::array<Slot, slotsCount> slots;
+        uint32_t clock;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single writer, many lock free readers; readers retry while a store is in progress
+template<typename T>
+class SeqLock
+{
+        static_assert( std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable" );
+
+    public:
+        auto store( const T& value ) -> void
+        {
+            const auto sequence{this->sequence.load( std::memory_order_relaxed )};
+            this->sequence.store( sequence + 1, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_release );
+            std::memcpy( &this->value, &value, sizeof( T ) );
+            this->sequence.store( sequence + 2, std::memory_order_release );
+        }
+
+        auto load() const -> T
+        {
+            auto value{T{}};
+            auto before{uint32_t{}};
+            auto after{uint32_t{}};
+            do
+            {
+                before = this->sequence.load( std::memory_order_acquire );
+                std::memcpy( &value, &this->value, sizeof( T ) );
+                std::atomic_thread_fence( std::memory_order_acquire );
+                after = this->sequence.load( std::memory_order_relaxed );
+            }
+            while ( ( before & 1 ) or before != after );
+            return value;
+        }
+
+    private:
+        std::atomic<uint32_t> sequence{0};
+        T value{};
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Lock-free queue for exactly one producer and one consumer task
+// push() and pop() are always inlined so an IRAM interrupt handler using them never jumps into flash
+template<typename T, size_t N>
+class SpscQueue
+{
+    public:
+        __attribute__( ( always_inline ) ) auto push( const T& value ) -> bool
+        {
+            const auto tail{this->tail.load( std::memory_order_relaxed )};
+            const auto next{( tail + 1 ) % slots.size()};
+            if ( next == this->head.load( std::memory_order_acquire ) )
+            {
+                return false;
+            }
+            slots[tail] = value;
+            this->tail.store( next, std::memory_order_release );
+            return true;
+        }
+
+        __attribute__( ( always_inline ) ) auto pop( T* value ) -> bool
+        {
+            const auto head{this->head.load( std::memory_order_relaxed )};
+            if ( head == this->tail.load( std::memory_order_acquire ) )
+            {
+                return false;
+            }
+            *value = slots[head];
+            this->head.store( ( head + 1 ) % slots.size(), std::memory_order_release );
+            return true;
+        }
+
+        auto size() const -> size_t
+        {
+            const auto head{this->head.load( std::memory_order_acquire )};
+            const auto tail{this->tail.load( std::memory_order_acquire )};
+            return ( tail + slots.size() - head ) % slots.size();
+        }
+
+        static constexpr auto capacity() -> size_t
+        {
+            return N;
+        }
+
+    private:
+        std::array<T, N + 1> slots{};
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <Arduino.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstdlib>
+#include <cstring>
+
+#include "Boot.hpp"
+#include "Scheduler.hpp"
+
+namespace Boot
+{
+    struct Stage
+    {
+        void( *init )();
+        std::vector<const char*> after;
+        Mode mode;
+    };
+
+    static std::vector<Stage> stages{};
+    // Written on the loop task, copied by the web handlers on the AsyncTCP task under lock
+    static Statistics statistics{};
+    static SemaphoreHandle_t lock{};
+    static size_t deferredNext{};
+
+    static auto find( const char* name ) -> const Statistics::Timing*
+    {
+        for ( const auto& timing : statistics.stages )
+        {
+            if ( std::strcmp( timing.name, name ) == 0 )
+            {
+                return &timing;
+            }
+        }
+        return nullptr;
+    }
+
+    static auto execute( size_t index ) -> void
+    {
+        auto& timing{statistics.stages[index]};
+        for ( const auto name : stages[index].after )
+        {
+            const auto dependency{find( name )};
+            if ( dependency == nullptr or not dependency->done )
+            {
+                log_e( "stage %s runs before %s", timing.name, name );
+                std::abort();
+            }
+        }
+
+        const auto start{static_cast<uint32_t>( esp_timer_get_time() )};
+        stages[index].init();
+        const auto duration{static_cast<uint32_t>( esp_timer_get_time() ) - start};
+
+        xSemaphoreTake( lock, portMAX_DELAY );
+        timing.start = start;
+        timing.duration = duration;
+        timing.done = true;
+        xSemaphoreGive( lock );
+
+        log_d( "%s: %u us", timing.name, timing.duration );
+    }
+
+    static auto step() -> void
+    {
+        while ( deferredNext < stages.size() and statistics.stages[deferredNext].done )
+        {
+            deferredNext++;
+        }
+        if ( deferredNext < stages.size() )
+        {
+            execute( deferredNext );
+        }
+        else
+        {
+            Scheduler::cancel( Boot::step );
+        }
+    }
+
+    auto stage( const char* name, void( *init )(), std::initializer_list<const char*> after, Mode mode ) -> void
+    {
+        // Stages are added from setup(), before any stage could start another task
+        if ( lock == nullptr )
+        {
+            lock = xSemaphoreCreateMutex();
+        }
+
+        stages.push_back( Stage{init, after, mode} );
+        xSemaphoreTake( lock, portMAX_DELAY );
+        statistics.stages.push_back( Statistics::Timing{name, 0, 0, false} );
+        xSemaphoreGive( lock );
+    }
+
+    auto run() -> void
+    {
+        for ( size_t n{0}; n < stages.size(); ++n )
+        {
+            if ( stages[n].mode == Mode::Now )
+            {
+                execute( n );
+            }
+        }
+        Scheduler::periodic( std::chrono::milliseconds( 10 ), Boot::step );
+    }
+
+    auto reading() -> void
+    {
+        if ( statistics.firstReading == 0 )
+        {
+            xSemaphoreTake( lock, portMAX_DELAY );
+            statistics.firstReading = esp_timer_get_time();
+            xSemaphoreGive( lock );
+            log_d( "first reading: %u us", statistics.firstReading );
+        }
+    }
+
+    auto Statistics::get() -> Statistics
+    {
+        xSemaphoreTake( lock, portMAX_DELAY );
+        const auto copy{statistics};
+        xSemaphoreGive( lock );
+        return copy;
+    }
+
+    auto Statistics::serialize( ArduinoJson::JsonVariant& json ) const -> void
+    {
+        for ( const auto& timing : this->stages )
+        {
+            auto stage{json["stages"].addElement()};
+            stage["name"] = timing.name;
+            stage["done"] = timing.done;
+            stage["start"] = timing.start / 1000.0;
+            stage["duration"] = timing.duration / 1000.0;
+        }
+        json["first_reading"] = this->firstReading / 1000.0;
+    }
+} // namespace Boot
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <ArduinoJson.hpp>
+#include <initializer_list>
+#include <vector>
+
+namespace Boot
+{
+    enum Mode
+    {
+        // Runs inside run(), before setup() returns
+        Now,
+        // Runs from the loop afterwards, one stage per pass, so sampling starts before slow stages
+        Deferred
+    };
+
+    struct Statistics
+    {
+        // Microseconds since reset
+        struct Timing
+        {
+            const char* name;
+            uint32_t start;
+            uint32_t duration;
+            bool done;
+        };
+
+        std::vector<Timing> stages;
+        uint32_t firstReading;
+
+        static auto get() -> Statistics;
+        auto serialize( ArduinoJson::JsonVariant& json ) const -> void;
+    };
+
+    // Stages run in the order they are added and abort the boot when one named in after has not run yet
+    auto stage( const char* name, void( *init )(), std::initializer_list<const char*> after = {}, Mode mode = Mode::Now ) -> void;
+    auto run() -> void;
+    // Records the first sensor reading since reset, later calls are ignored
+    auto reading() -> void;
+} // namespace Boot
@@ -0,0 +1,175 @@
+#include <Arduino.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <utility>
+
+#include "Bus.hpp"
+#include "Scheduler.hpp"
+
+namespace Bus
+{
+    struct Request
+    {
+        Device device;
+        Transaction transaction;
+        Completion completion;
+        int64_t submitted;
+        bool ok;
+    };
+
+    static constexpr size_t queueCapacity{16};
+
+    static SemaphoreHandle_t lock{};
+    static TaskHandle_t busTask{};
+    static std::array<std::deque<Request>, PrioritiesCount> pending{};
+    static std::deque<Request> completed{};
+    static Statistics statistics{};
+
+    // Highest priority first, FIFO within a priority, so a long run of LCD rows yields to every sensor read
+    static auto take( Request* request ) -> bool
+    {
+        xSemaphoreTake( lock, portMAX_DELAY );
+        for ( auto& queue : pending )
+        {
+            if ( not queue.empty() )
+            {
+                *request = std::move( queue.front() );
+                queue.pop_front();
+                xSemaphoreGive( lock );
+                return true;
+            }
+        }
+        xSemaphoreGive( lock );
+        return false;
+    }
+
+    static auto finish( Request&& request ) -> void
+    {
+        const auto latency{static_cast<uint32_t>( esp_timer_get_time() - request.submitted )};
+
+        xSemaphoreTake( lock, portMAX_DELAY );
+        auto& counters{statistics.devices[request.device]};
+        counters.transactions++;
+        if ( not request.ok )
+        {
+            counters.errors++;
+        }
+        counters.latencyLast = latency;
+        counters.latencyMax = std::max( counters.latencyMax, latency );
+        if ( request.completion )
+        {
+            completed.push_back( std::move( request ) );
+        }
+        xSemaphoreGive( lock );
+    }
+
+    static auto serve( void* ) -> void
+    {
+        log_d( "begin" );
+
+        while ( true )
+        {
+            ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+            auto request{Request{}};
+            while ( take( &request ) )
+            {
+                request.ok = request.transaction();
+                finish( std::move( request ) );
+            }
+        }
+    }
+
+    static auto dispatch() -> void
+    {
+        auto ready{std::deque<Request>{}};
+
+        xSemaphoreTake( lock, portMAX_DELAY );
+        ready.swap( completed );
+        xSemaphoreGive( lock );
+
+        for ( auto& request : ready )
+        {
+            request.completion( request.ok );
+        }
+    }
+
+    auto init() -> void
+    {
+        log_d( "begin" );
+
+        lock = xSemaphoreCreateMutex();
+        xTaskCreatePinnedToCore( Bus::serve, "bus", 4096, nullptr, 2, &busTask, 1 );
+
+        Scheduler::periodic( std::chrono::milliseconds( 10 ), Bus::dispatch );
+
+        log_d( "end" );
+    }
+
+    auto submit( Device device, Priority priority, Transaction transaction, Completion completion ) -> bool
+    {
+        xSemaphoreTake( lock, portMAX_DELAY );
+        auto& queue{pending[priority]};
+        if ( queue.size() >= queueCapacity )
+        {
+            statistics.rejected++;
+            xSemaphoreGive( lock );
+            log_d( "bus queue %u full", priority );
+            return false;
+        }
+        queue.push_back( Request{device, std::move( transaction ), std::move( completion ), esp_timer_get_time(), false} );
+        xSemaphoreGive( lock );
+
+        xTaskNotifyGive( busTask );
+        return true;
+    }
+
+    auto execute( Device device, Transaction transaction ) -> bool
+    {
+        auto done{xSemaphoreCreateBinary()};
+        auto ok{false};
+
+        // The caller's locals are only touched before the give, the caller may return right after it
+        const auto queued{submit( device, Priority::High, [&transaction, &ok, done]()
+        {
+            const auto result{transaction()};
+            ok = result;
+            xSemaphoreGive( done );
+            return result;
+        } )};
+
+        if ( queued )
+        {
+            xSemaphoreTake( done, portMAX_DELAY );
+        }
+        vSemaphoreDelete( done );
+        return queued and ok;
+    }
+
+    auto Statistics::get() -> Statistics
+    {
+        xSemaphoreTake( lock, portMAX_DELAY );
+        const auto copy{statistics};
+        xSemaphoreGive( lock );
+        return copy;
+    }
+
+    auto Statistics::serialize( ArduinoJson::JsonVariant& json ) const -> void
+    {
+        static constexpr std::array<const char*, DevicesCount> names{"bme280", "ds3231", "lcd", "ads1115"};
+
+        for ( size_t n{0}; n < this->devices.size(); ++n )
+        {
+            auto device{json[names[n]]};
+            device["transactions"] = this->devices[n].transactions;
+            device["errors"] = this->devices[n].errors;
+            device["latency_last"] = this->devices[n].latencyLast;
+            device["latency_max"] = this->devices[n].latencyMax;
+        }
+        json["rejected"] = this->rejected;
+    }
+} // namespace Bus
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <ArduinoJson.hpp>
+#include <array>
+#include <functional>
+
+namespace Bus
+{
+    enum Device
+    {
+        Bme280,
+        Ds3231,
+        Lcd,
+        Ads1115,
+        DevicesCount
+    };
+
+    enum Priority
+    {
+        High,
+        Normal,
+        Low,
+        PrioritiesCount
+    };
+
+    // Runs on the bus task, the only one allowed to touch Wire, returns false on a bus error
+    using Transaction = std::function<bool()>;
+    // Runs on the loop task once the transaction is done
+    using Completion = std::function<void( bool ok )>;
+
+    struct Statistics
+    {
+        struct Counters
+        {
+            uint32_t transactions;
+            uint32_t errors;
+            uint32_t latencyLast;
+            uint32_t latencyMax;
+        };
+
+        std::array<Counters, DevicesCount> devices;
+        uint32_t rejected;
+
+        static auto get() -> Statistics;
+        auto serialize( ArduinoJson::JsonVariant& json ) const -> void;
+    };
+
+    auto init() -> void;
+    // False when the queue of that priority is full, the transaction is then dropped
+    auto submit( Device device, Priority priority, Transaction transaction, Completion completion = nullptr ) -> bool;
+    // Blocks the calling task until the transaction ran, never call it from a transaction
+    auto execute( Device device, Transaction transaction ) -> bool;
+} // namespace Bus
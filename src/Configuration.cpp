@@ -3,18 +3,25 @@
 #include <ArduinoJson.hpp>
 #include <FS.h>
 #include <FastCRC.h>
+#include <Preferences.h>
 #include <SD.h>
-#include <WiFi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <esp_log.h>
+#include <esp_system.h>
 
 #include <string>
 //#undef B1
 //#include <nlohmannJson.hpp>
 
 #include "Configuration.hpp"
+#include "Database.hpp"
 #include "Peripherals.hpp"
+#include "Scheduler.hpp"
 
 static const Configuration defaultCfg
 {
@@ -42,54 +49,67 @@ static const Configuration defaultCfg
     {
         true,
         {22, 0},
-        {8, 0}
+        {8, 0},
+        5
+    },
+    {
+        Configuration::Storage::Engine::Sqlite,
+        6,
+        1800
     },
     {
         {
+            true,
+            "Ext",
+            Configuration::Sensor::Driver::Internal,
+            0x00,
+            0,
+            Configuration::Sensor::Type::MPX5500,
+            0.0,
+            395.6,
+            {
+                0.00115189,
+                0.10866961
+            },
             {
                 true,
-                "Ext",
-                Configuration::Sensor::Type::MPX5500,
-                0.0,
-                395.6,
-                {
-                    0.00115189,
-                    0.10866961
-                },
-                {
-                    true,
-                    25.0
-                }
+                25.0
+            }
+        },
+        {
+            true,
+            "Sup",
+            Configuration::Sensor::Driver::Internal,
+            0x00,
+            1,
+            Configuration::Sensor::Type::MPX5100,
+            49.18,
+            52.55,
+            {
+                0.00115442,
+                0.10876640
             },
             {
                 true,
-                "Sup",
-                Configuration::Sensor::Type::MPX5100,
-                49.18,
-                52.55,
-                {
-                    0.00115442,
-                    0.10876640
-                },
-                {
-                    true,
-                    40.0
-                }
+                40.0
+            }
+        },
+        {
+            true,
+            "Inf",
+            Configuration::Sensor::Driver::Internal,
+            0x00,
+            2,
+            Configuration::Sensor::Type::MPX5100,
+            17.9,
+            22.98,
+            {
+                0.00110177,
+                0.25609925
             },
             {
                 true,
-                "Inf",
-                Configuration::Sensor::Type::MPX5100,
-                17.9,
-                22.98,
-                {
-                    0.00110177,
-                    0.25609925
-                },
-                {
-                    true,
-                    25.0
-                }
+                25.0
             }
         }
     }
@@ -98,18 +118,431 @@ static const Configuration defaultCfg
 static std::array<uint8_t, 6> stationMAC{};
 static std::array<uint8_t, 6> accessPointMAC{};
 
+// Fixed size image of the configuration, one NVS blob read loads it whole
+struct Record
+{
+    struct Network
+    {
+        bool enabled;
+        std::array<uint8_t, 4> ip;
+        std::array<uint8_t, 4> netmask;
+        std::array<uint8_t, 4> gateway;
+        uint16_t port;
+        uint16_t duration;
+        std::array<char, 32 + 1> user;
+        std::array<char, 64 + 1> password;
+    };
+
+    struct Sensor
+    {
+        bool enabled;
+        uint8_t driver;
+        uint8_t address;
+        uint8_t channel;
+        uint8_t type;
+        bool alarmEnabled;
+        std::array<char, 15 + 1> name;
+        double min;
+        double max;
+        double angularCoefficient;
+        double linearCoefficient;
+        double alarmValue;
+    };
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t sequence;
+    Network station;
+    Network accessPoint;
+    bool autoSleepWakeUpEnabled;
+    std::array<uint8_t, 2> sleepTime;
+    std::array<uint8_t, 2> wakeUpTime;
+    uint16_t logInterval;
+    uint8_t engine;
+    uint16_t batchSize;
+    uint16_t batchAge;
+    uint8_t sensorsCount;
+    std::array<Sensor, Configuration::maxSensors> sensors;
+    // CRC32 of every byte before it
+    uint32_t crc;
+};
+
+static constexpr uint32_t recordMagic{0x57434346};
+// Bump whenever Record changes, an older record is then ignored and the SD file or the defaults take over
+static constexpr uint16_t recordVersion{1};
+static constexpr std::array<const char*, 2> slotKeys{"slot0", "slot1"};
+
+static Preferences preferences{};
+static size_t activeSlot{0};
+static uint32_t activeSequence{0};
+
+// Leaves time for the response to go out before a network change drops the connection
+static constexpr auto settleTime{std::chrono::seconds( 1 )};
+
+static SemaphoreHandle_t lock{};
+static Configuration pending{};
+static bool pendingValid{false};
+static std::chrono::steady_clock::time_point pendingTime{};
+static std::array<bool( * )( const Configuration& ), 8> handlers{};
+static size_t handlersCount{};
+
+static auto copyString( const std::string& from, char* to, size_t size ) -> void
+{
+    if ( from.size() >= size )
+    {
+        log_e( "string truncated = %s", from.c_str() );
+    }
+    std::strncpy( to, from.c_str(), size - 1 );
+}
+
+// Enums arrive as plain numbers from JSON and NVS, and index tables of drivers and conversions
+template<typename Enum>
+static auto inRange( int32_t value, Enum last ) -> bool
+{
+    return value >= 0 and value <= static_cast<int32_t>( last );
+}
+
+static auto recordCrc( const Record& record ) -> uint32_t
+{
+    auto crc32{FastCRC32{}};
+    return crc32.crc32( reinterpret_cast<const uint8_t*>( &record ), offsetof( Record, crc ) );
+}
+
+// Station and AccessPoint share these fields
+template<typename Network>
+static auto packNetwork( const Network& network, Record::Network* packed ) -> void
+{
+    packed->enabled = network.enabled;
+    packed->ip = network.ip;
+    packed->netmask = network.netmask;
+    packed->gateway = network.gateway;
+    packed->port = network.port;
+    copyString( network.user, packed->user.data(), packed->user.size() );
+    copyString( network.password, packed->password.data(), packed->password.size() );
+}
+
+template<typename Network>
+static auto unpackNetwork( const Record::Network& packed, Network* network ) -> void
+{
+    network->enabled = packed.enabled;
+    network->ip = packed.ip;
+    network->netmask = packed.netmask;
+    network->gateway = packed.gateway;
+    network->port = packed.port;
+    network->user = packed.user.data();
+    network->password = packed.password.data();
+}
+
+static auto pack( const Configuration& cfg, uint32_t sequence, Record* record ) -> void
+{
+    // Padding takes part in the CRC and in the change detection, so it must be zero as well
+    std::memset( record, 0, sizeof( Record ) );
+
+    record->magic = recordMagic;
+    record->version = recordVersion;
+    record->size = sizeof( Record );
+    record->sequence = sequence;
+
+    packNetwork( cfg.station, &record->station );
+    packNetwork( cfg.accessPoint, &record->accessPoint );
+    record->accessPoint.duration = cfg.accessPoint.duration;
+
+    record->autoSleepWakeUpEnabled = cfg.autoSleepWakeUp.enabled;
+    record->sleepTime = cfg.autoSleepWakeUp.sleepTime;
+    record->wakeUpTime = cfg.autoSleepWakeUp.wakeUpTime;
+    record->logInterval = cfg.autoSleepWakeUp.logInterval;
+
+    record->engine = static_cast<uint8_t>( cfg.storage.engine );
+    record->batchSize = cfg.storage.batchSize;
+    record->batchAge = cfg.storage.batchAge;
+
+    record->sensorsCount = static_cast<uint8_t>( std::min( cfg.sensors.size(), size_t{Configuration::maxSensors} ) );
+    for ( size_t n{0}; n < record->sensorsCount; ++n )
+    {
+        const auto& sensor{cfg.sensors[n]};
+        auto& packed{record->sensors[n]};
+        packed.enabled = sensor.enabled;
+        packed.driver = static_cast<uint8_t>( sensor.driver );
+        packed.address = sensor.address;
+        packed.channel = sensor.channel;
+        packed.type = static_cast<uint8_t>( sensor.type );
+        packed.alarmEnabled = sensor.alarm.enabled;
+        copyString( sensor.name, packed.name.data(), packed.name.size() );
+        packed.min = sensor.min;
+        packed.max = sensor.max;
+        packed.angularCoefficient = sensor.calibration.angularCoefficient;
+        packed.linearCoefficient = sensor.calibration.linearCoefficient;
+        packed.alarmValue = sensor.alarm.value;
+    }
+
+    record->crc = recordCrc( *record );
+}
+
+static auto unpack( const Record& record, Configuration* cfg ) -> void
+{
+    unpackNetwork( record.station, &cfg->station );
+    unpackNetwork( record.accessPoint, &cfg->accessPoint );
+    cfg->accessPoint.duration = record.accessPoint.duration;
+
+    cfg->autoSleepWakeUp.enabled = record.autoSleepWakeUpEnabled;
+    cfg->autoSleepWakeUp.sleepTime = record.sleepTime;
+    cfg->autoSleepWakeUp.wakeUpTime = record.wakeUpTime;
+    cfg->autoSleepWakeUp.logInterval = record.logInterval;
+
+    cfg->storage.engine = static_cast<Configuration::Storage::Engine>( record.engine );
+    cfg->storage.batchSize = record.batchSize;
+    cfg->storage.batchAge = record.batchAge;
+
+    cfg->sensors.resize( std::min( size_t{record.sensorsCount}, size_t{Configuration::maxSensors} ) );
+    for ( size_t n{0}; n < cfg->sensors.size(); ++n )
+    {
+        const auto& packed{record.sensors[n]};
+        auto& sensor{cfg->sensors[n]};
+        sensor.enabled = packed.enabled;
+        sensor.name = packed.name.data();
+        sensor.driver = static_cast<Configuration::Sensor::Driver>( packed.driver );
+        sensor.address = packed.address;
+        sensor.channel = packed.channel;
+        sensor.type = static_cast<Configuration::Sensor::Type>( packed.type );
+        sensor.min = packed.min;
+        sensor.max = packed.max;
+        sensor.calibration.angularCoefficient = packed.angularCoefficient;
+        sensor.calibration.linearCoefficient = packed.linearCoefficient;
+        sensor.alarm.enabled = packed.alarmEnabled;
+        sensor.alarm.value = packed.alarmValue;
+    }
+}
+
+// The CRC only proves the record is the one written, fields an older or broken firmware wrote out of range are
+// caught here so that the other slot or the defaults take over
+static auto validRecord( const Record& record ) -> bool
+{
+    const auto terminated{[]( const auto & text )
+    {
+        return text.back() == '\0';
+    }};
+    const auto time{[]( const std::array<uint8_t, 2>& hourMinute )
+    {
+        return hourMinute[0] < 24 and hourMinute[1] < 60;
+    }};
+
+    if ( not inRange( record.engine, Configuration::Storage::Engine::Compressed ) or record.sensorsCount > Configuration::maxSensors )
+    {
+        return false;
+    }
+    if ( not time( record.sleepTime ) or not time( record.wakeUpTime ) or record.logInterval > Configuration::AutoSleepWakeUp::maxLogInterval )
+    {
+        return false;
+    }
+    for ( const auto* network : {&record.station, &record.accessPoint} )
+    {
+        if ( not terminated( network->user ) or not terminated( network->password ) )
+        {
+            return false;
+        }
+    }
+    for ( size_t n{0}; n < record.sensorsCount; ++n )
+    {
+        const auto& sensor{record.sensors[n]};
+        if ( not inRange( sensor.driver, Configuration::Sensor::Driver::Ads1115 ) or not inRange( sensor.type, Configuration::Sensor::Type::MPX5700 ) or not terminated( sensor.name ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static auto readSlot( size_t slot, Record* record ) -> bool
+{
+    if ( preferences.getBytesLength( slotKeys[slot] ) != sizeof( Record ) )
+    {
+        return false;
+    }
+    if ( preferences.getBytes( slotKeys[slot], record, sizeof( Record ) ) != sizeof( Record ) )
+    {
+        return false;
+    }
+    return record->magic == recordMagic and record->version == recordVersion and record->size == sizeof( Record ) and record->crc == recordCrc( *record ) and validRecord( *record );
+}
+
+// The newest valid slot wins, a write interrupted halfway leaves the other one intact
+static auto loadRecord( Configuration* cfg ) -> bool
+{
+    auto found{false};
+    for ( size_t slot{0}; slot < slotKeys.size(); ++slot )
+    {
+        auto record{Record{}};
+        if ( not readSlot( slot, &record ) )
+        {
+            log_d( "slot %u invalid", slot );
+            continue;
+        }
+        if ( not found or static_cast<int32_t>( record.sequence - activeSequence ) > 0 )
+        {
+            found = true;
+            activeSlot = slot;
+            activeSequence = record.sequence;
+            unpack( record, cfg );
+        }
+    }
+    return found;
+}
+
+static auto importFile( Configuration* cfg ) -> bool
+{
+    if ( not SD.exists( "/configuration.json" ) )
+    {
+        log_d( "file not found" );
+        return false;
+    }
+
+    auto file{SD.open( "/configuration.json", FILE_READ )};
+    file.setTimeout( 3000 );
+    if ( not file )
+    {
+        log_e( "file error" );
+        return false;
+    }
+
+    auto doc{ArduinoJson::DynamicJsonDocument{Configuration::jsonCapacity}};
+    auto err{ArduinoJson::deserializeJson( doc, file )};
+    file.close();
+
+    if ( err != ArduinoJson::DeserializationError::Ok )
+    {
+        log_d( "json error = %s", err.c_str() );
+        return false;
+    }
+
+    auto json{doc.as<ArduinoJson::JsonVariant>()};
+    cfg->deserialize( json );
+    return true;
+}
+
+// Only refreshes a file that is already there, deleting it from the card turns the export off
+static auto exportFile( const Configuration& cfg ) -> void
+{
+    if ( not SD.exists( "/configuration.json" ) )
+    {
+        return;
+    }
+
+    auto file{SD.open( "/configuration.json", FILE_WRITE )};
+    file.setTimeout( 3000 );
+    if ( not file )
+    {
+        log_e( "file error" );
+        return;
+    }
+
+    auto doc{ArduinoJson::DynamicJsonDocument{Configuration::jsonCapacity}};
+    auto json{doc.as<ArduinoJson::JsonVariant>()};
+
+    cfg.serialize( json );
+
+    ArduinoJson::serializeJsonPretty( doc, file );
+    file.close();
+}
+
+static auto applyPending() -> void
+{
+    auto next{Configuration{}};
+    xSemaphoreTake( lock, portMAX_DELAY );
+    const auto ready{pendingValid and std::chrono::steady_clock::now() - pendingTime >= settleTime};
+    if ( ready )
+    {
+        next = pending;
+        pendingValid = false;
+    }
+    xSemaphoreGive( lock );
+    if ( not ready )
+    {
+        return;
+    }
+
+    log_d( "begin" );
+
+    // request() saved it already
+    const auto previous{cfg};
+    xSemaphoreTake( lock, portMAX_DELAY );
+    cfg = next;
+    xSemaphoreGive( lock );
+
+    for ( size_t n{0}; n < handlersCount; ++n )
+    {
+        if ( not handlers[n]( previous ) )
+        {
+            // Already saved, the restart picks the change up
+            log_d( "restart" );
+            Database::flush();
+            esp_restart();
+        }
+    }
+
+    log_d( "end" );
+}
+
 auto Configuration::init() -> void
 {
     log_d( "begin" );
 
-    WiFi.mode( WIFI_MODE_APSTA );
-    WiFi.macAddress( stationMAC.data() );
-    WiFi.softAPmacAddress( accessPointMAC.data() );
-    WiFi.mode( WIFI_MODE_NULL );
+    // Derived from the eFuse base MAC, so the WiFi driver does not have to start
+    esp_read_mac( stationMAC.data(), ESP_MAC_WIFI_STA );
+    esp_read_mac( accessPointMAC.data(), ESP_MAC_WIFI_SOFTAP );
+
+    if ( not preferences.begin( "configuration", false ) )
+    {
+        log_e( "nvs error" );
+        std::abort();
+    }
+
+    lock = xSemaphoreCreateMutex();
+    Scheduler::periodic( std::chrono::milliseconds( 250 ), applyPending );
 
     log_d( "end" );
 }
 
+auto Configuration::get() -> Configuration
+{
+    xSemaphoreTake( lock, portMAX_DELAY );
+    const auto copy{cfg};
+    xSemaphoreGive( lock );
+    return copy;
+}
+
+auto Configuration::request( const ArduinoJson::JsonVariant& json ) -> bool
+{
+    // Requests arriving before the previous one is applied build on it
+    xSemaphoreTake( lock, portMAX_DELAY );
+    auto next{pendingValid ? pending : cfg};
+    xSemaphoreGive( lock );
+    next.deserialize( json );
+
+    // Outside the lock, the NVS and SD writes would hold up every get()
+    if ( not Configuration::save( next ) )
+    {
+        return false;
+    }
+
+    xSemaphoreTake( lock, portMAX_DELAY );
+    pending = next;
+    pendingValid = true;
+    pendingTime = std::chrono::steady_clock::now();
+    xSemaphoreGive( lock );
+    return true;
+}
+
+auto Configuration::onChange( bool( *handler )( const Configuration& previous ) ) -> void
+{
+    if ( handlersCount == handlers.size() )
+    {
+        log_e( "handler table full" );
+        std::abort();
+    }
+    handlers[handlersCount++] = handler;
+}
+
 auto Configuration::serialize( ArduinoJson::JsonVariant& json ) const -> void
 {
     {
@@ -173,6 +606,14 @@ auto Configuration::serialize( ArduinoJson::JsonVariant& json ) const -> void
         {
             autoSleepWakeUp["wakeup_time"].add( n );
         }
+        autoSleepWakeUp["log_interval"] = this->autoSleepWakeUp.logInterval;
+    }
+    {
+        auto storage{json["storage"]};
+
+        storage["engine"] = static_cast<int16_t>( this->storage.engine );
+        storage["batch_size"] = this->storage.batchSize;
+        storage["batch_age"] = this->storage.batchAge;
     }
     {
         auto sensors{json["sensors"]};
@@ -183,6 +624,9 @@ auto Configuration::serialize( ArduinoJson::JsonVariant& json ) const -> void
 
             sensor["enabled"] = s.enabled;
             sensor["name"] = s.name;
+            sensor["driver"] = static_cast<int16_t>( s.driver );
+            sensor["address"] = s.address;
+            sensor["channel"] = s.channel;
             sensor["type"] = static_cast<int16_t>( s.type );
             sensor["min"] = s.min;
             sensor["max"] = s.max;
@@ -374,11 +818,53 @@ auto Configuration::deserialize( const ArduinoJson::JsonVariant& json ) -> void
                 }
             }
         }
+        {
+            const auto logInterval{autoSleepWakeUp["log_interval"]};
+            if ( logInterval.is<uint16_t>() and logInterval.as<uint16_t>() > AutoSleepWakeUp::maxLogInterval )
+            {
+                log_e( "log interval out of range = %u", logInterval.as<uint16_t>() );
+            }
+            else if ( logInterval.is<uint16_t>() )
+            {
+                this->autoSleepWakeUp.logInterval = logInterval.as<uint16_t>();
+            }
+        }
+    }
+    {
+        const auto storage{json["storage"]};
+        {
+            const auto engine{storage["engine"]};
+            if ( engine.is<int16_t>() and not inRange( engine.as<int16_t>(), Configuration::Storage::Engine::Compressed ) )
+            {
+                log_e( "engine out of range = %d", engine.as<int16_t>() );
+            }
+            else if ( engine.is<int16_t>() )
+            {
+                this->storage.engine = static_cast<Configuration::Storage::Engine>( engine.as<int16_t>() );
+            }
+        }
+        {
+            const auto batchSize{storage["batch_size"]};
+            if ( batchSize.is<uint16_t>() )
+            {
+                this->storage.batchSize = batchSize.as<uint16_t>();
+            }
+        }
+        {
+            const auto batchAge{storage["batch_age"]};
+            if ( batchAge.is<uint16_t>() )
+            {
+                this->storage.batchAge = batchAge.as<uint16_t>();
+            }
+        }
     }
     {
         const auto sensors{json["sensors"]};
-        if ( sensors.is<ArduinoJson::JsonArray>() and sensors.size() == this->sensors.size() )
+        if ( sensors.is<ArduinoJson::JsonArray>() and sensors.size() <= maxSensors )
         {
+            // Sensors added past the current list start from the last one, so a new tank only needs its differences
+            const auto base{this->sensors.empty() ? defaultCfg.sensors.back() : this->sensors.back()};
+            this->sensors.resize( sensors.size(), base );
             for ( auto i{0}; i < this->sensors.size(); ++i )
             {
                 const auto sensor{sensors[i]};
@@ -396,9 +882,38 @@ auto Configuration::deserialize( const ArduinoJson::JsonVariant& json ) -> void
                         this->sensors[i].name = name.as<std::string>();
                     }
                 }
+                {
+                    const auto driver{ sensor["driver"] };
+                    if( driver.is<int16_t>() and not inRange( driver.as<int16_t>(), Configuration::Sensor::Driver::Ads1115 ) )
+                    {
+                        log_e( "driver out of range = %d", driver.as<int16_t>() );
+                    }
+                    else if( driver.is<int16_t>() )
+                    {
+                        this->sensors[i].driver = static_cast<Configuration::Sensor::Driver>( driver.as<int16_t>() );
+                    }
+                }
+                {
+                    const auto address{ sensor["address"] };
+                    if( address.is<uint8_t>() )
+                    {
+                        this->sensors[i].address = address.as<uint8_t>();
+                    }
+                }
+                {
+                    const auto channel{ sensor["channel"] };
+                    if( channel.is<uint8_t>() )
+                    {
+                        this->sensors[i].channel = channel.as<uint8_t>();
+                    }
+                }
                 {
                     const auto type{ sensor["type"] };
-                    if( type.is<int16_t>() )
+                    if( type.is<int16_t>() and not inRange( type.as<int16_t>(), Configuration::Sensor::Type::MPX5700 ) )
+                    {
+                        log_e( "type out of range = %d", type.as<int16_t>() );
+                    }
+                    else if( type.is<int16_t>() )
                     {
                         this->sensors[i].type = static_cast<Configuration::Sensor::Type>( type.as<int16_t>() );
                     }
@@ -462,62 +977,48 @@ auto Configuration::load( Configuration* cfg ) -> void
 
     *cfg = defaultCfg;
 
-    if ( not SD.exists( "/configuration.json" ) )
+    if ( not loadRecord( cfg ) )
     {
-        log_d( "file not found" );
-    }
-    else
-    {
-        auto file{SD.open( "/configuration.json", FILE_READ )};
-        file.setTimeout( 3000 );
-        if ( not file )
-        {
-            log_e( "file error" );
-        }
-        else
-        {
-            auto doc{ArduinoJson::DynamicJsonDocument{3072}};
-            auto err{ArduinoJson::deserializeJson( doc, file )};
-            file.close();
-
-            if ( err != ArduinoJson::DeserializationError::Ok )
-            {
-                log_d( "json error = %s", err.c_str() );
-            }
-            else
-            {
-                auto json{doc.as<ArduinoJson::JsonVariant>()};
-                cfg->deserialize( json );
-            }
-        }
+        // First boot or a record from an older firmware, the SD file is imported when there is one
+        importFile( cfg );
+        Configuration::save( *cfg );
     }
 
-    Configuration::save( *cfg );
+    cfg->station.mac = stationMAC;
+    cfg->accessPoint.mac = accessPointMAC;
 
     log_d( "end" );
 }
 
-auto Configuration::save( const Configuration& cfg ) -> void
+auto Configuration::save( const Configuration& cfg ) -> bool
 {
     log_d( "begin" );
 
-    auto file{SD.open( "/configuration.json", FILE_WRITE )};
-    file.setTimeout( 3000 );
-    if ( not file )
+    auto record{Record{}};
+    auto current{Record{}};
+    pack( cfg, activeSequence, &record );
+    if ( readSlot( activeSlot, &current ) and std::memcmp( &current, &record, sizeof( Record ) ) == 0 )
     {
-        log_e( "file error" );
-        std::abort();
+        log_d( "unchanged" );
+        log_d( "end" );
+        return true;
     }
 
-    auto doc{ArduinoJson::DynamicJsonDocument{3072}};
-    auto json{doc.as<ArduinoJson::JsonVariant>()};
+    // Written to the slot not holding the current record, which stays valid until the new one reads back
+    const auto slot{( activeSlot + 1 ) % slotKeys.size()};
+    pack( cfg, activeSequence + 1, &record );
+    auto verify{Record{}};
+    if ( preferences.putBytes( slotKeys[slot], &record, sizeof( Record ) ) != sizeof( Record ) or not readSlot( slot, &verify ) )
+    {
+        // The active slot was not touched and still holds the previous configuration
+        log_e( "nvs error" );
+        return false;
+    }
+    activeSlot = slot;
+    activeSequence = record.sequence;
 
-    cfg.serialize( json );
-
-    ArduinoJson::serializeJsonPretty( doc, file );
-    file.close();
+    exportFile( cfg );
 
     log_d( "end" );
+    return true;
 }
-
-Configuration cfg{};
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include <ArduinoJson.hpp>
 #include <array>
+#include <vector>
 
 struct Configuration
 {
@@ -37,10 +38,34 @@ struct Configuration
         bool enabled;
         std::array<uint8_t, 2> sleepTime;
         std::array<uint8_t, 2> wakeUpTime;
+        // Minutes between samples logged while asleep, 0 sleeps through the night
+        uint16_t logInterval;
+
+        // The ULP counts the one second readings of an interval in a 16 bit word
+        static constexpr uint16_t maxLogInterval{1092};
+    };
+
+    struct Storage
+    {
+        enum Engine
+        {
+            Sqlite,
+            Compressed
+        };
+
+        Engine engine;
+        uint16_t batchSize;
+        uint16_t batchAge;
     };
 
     struct Sensor
     {
+        enum Driver
+        {
+            Internal,
+            Ads1115
+        };
+
         enum Type
         {
             MPX5050,
@@ -63,6 +88,9 @@ struct Configuration
 
         bool enabled;
         std::string name;
+        Driver driver;
+        uint8_t address;
+        uint8_t channel;
         Type type;
         double min;
         double max;
@@ -70,14 +98,27 @@ struct Configuration
         Alarm alarm;
     };
 
+    // Four ADS1115 on the bus, four single ended inputs each
+    static constexpr size_t maxSensors{16};
+    static constexpr size_t jsonCapacity{1024 + 384 * maxSensors};
+
     Station station;
     AccessPoint accessPoint;
     AutoSleepWakeUp autoSleepWakeUp;
-    std::array<Sensor, 3> sensors;
+    Storage storage;
+    std::vector<Sensor> sensors;
 
     static auto init() -> void;
     static auto load( Configuration* cfg ) -> void;
-    static auto save( const Configuration& cfg ) -> void;
+    // False when NVS refused the record, the previous configuration then stays
+    static auto save( const Configuration& cfg ) -> bool;
+    // Copy of cfg for tasks other than the loop, which is the only one changing it
+    static auto get() -> Configuration;
+    // Merges json into the configuration and saves it, the loop applies it shortly after. Called from the AsyncTCP
+    // task only, false when the save failed and nothing changes
+    static auto request( const ArduinoJson::JsonVariant& json ) -> bool;
+    // Called on the loop with cfg already changed, false when the module needs a restart to follow it
+    static auto onChange( bool( *handler )( const Configuration& previous ) ) -> void;
 
     auto serialize( ArduinoJson::JsonVariant& json ) const -> void;
     auto deserialize( const ArduinoJson::JsonVariant& json ) -> void;
@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Csv.hpp"
+#include "Utils.hpp"
+
+namespace Csv
+{
+    auto header( char* first, size_t sensors ) -> char*
+    {
+        static constexpr auto header{"id;datetime;temperature;humidity;pressure"};
+
+        first = std::copy( header, header + std::strlen( header ), first );
+        for ( size_t n{0}; n < sensors; ++n )
+        {
+            static constexpr auto sensor{";sensor_"};
+
+            first = std::copy( sensor, sensor + std::strlen( sensor ), first );
+            first = Utils::toChars( first, static_cast<int64_t>( n ) );
+        }
+        *first++ = '\r';
+        *first++ = '\n';
+        return first;
+    }
+
+    auto row( char* first, int64_t id, std::time_t dateTime, double temperature, double humidity, double pressure, const double* sensors, size_t sensorsCount ) -> char*
+    {
+        first = Utils::toChars( first, id );
+        *first++ = ';';
+        first = Utils::DateTime::toChars( first, dateTime );
+        for ( const auto value : {temperature, humidity, pressure} )
+        {
+            *first++ = ';';
+            first = Utils::toChars( first, value, decimals, ',' );
+        }
+        for ( size_t n{0}; n < sensorsCount; ++n )
+        {
+            *first++ = ';';
+            first = Utils::toChars( first, sensors[n], decimals, ',' );
+        }
+        *first++ = '\r';
+        *first++ = '\n';
+        return first;
+    }
+} // namespace Csv
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+// Rows of /data.csv: ';' separated fields, decimal commas and CRLF, written straight into the response buffer
+namespace Csv
+{
+    static constexpr uint8_t decimals{3};
+
+    constexpr auto rowMaxLen( size_t sensors ) -> size_t
+    {
+        return 64 + 32 * ( 3 + sensors );
+    }
+
+    auto header( char* first, size_t sensors ) -> char*;
+    auto row( char* first, int64_t id, std::time_t dateTime, double temperature, double humidity, double pressure, const double* sensors, size_t sensorsCount ) -> char*;
+
+    // Fills each chunk with as many rows as fit, the row crossing the end of a chunk goes through carry
+    template<size_t RowMaxLen>
+    class Chunks
+    {
+        public:
+            // format( char* first ) writes one row and returns its end, or nullptr once there are no rows left
+            template<typename Format>
+            auto begin( Format format ) -> void
+            {
+                this->carryFirst = 0;
+                this->carryLast = format( this->carry.data() ) - this->carry.data();
+            }
+
+            template<typename Format>
+            auto fill( char* first, char* last, Format format ) -> char*
+            {
+                // Rest of a row that did not fit in the previous chunk
+                const auto carried{std::min<size_t>( this->carryLast - this->carryFirst, last - first )};
+                std::memcpy( first, this->carry.data() + this->carryFirst, carried );
+                this->carryFirst += carried;
+                first += carried;
+
+                while ( first < last and this->carryFirst == this->carryLast )
+                {
+                    if ( static_cast<size_t>( last - first ) >= RowMaxLen )
+                    {
+                        const auto end{format( first )};
+                        if ( end == nullptr )
+                        {
+                            break;
+                        }
+                        first = end;
+                    }
+                    else
+                    {
+                        const auto end{format( this->carry.data() )};
+                        if ( end == nullptr )
+                        {
+                            break;
+                        }
+                        this->carryFirst = 0;
+                        this->carryLast = end - this->carry.data();
+
+                        const auto chunk{std::min<size_t>( this->carryLast, last - first )};
+                        std::memcpy( first, this->carry.data(), chunk );
+                        this->carryFirst = chunk;
+                        first += chunk;
+                    }
+                }
+                return first;
+            }
+
+        private:
+            std::array<char, RowMaxLen> carry{};
+            size_t carryFirst{0};
+            size_t carryLast{0};
+    };
+} // namespace Csv
@@ -1,23 +1,81 @@
 #include <Arduino.h>
 
 #include <FS.h>
+#include <cmath>
 #include <cstdlib>
+#include <cstdio>
 #include <esp_log.h>
 #include <sqlite3.h>
 #include <future>
 #include <thread>
 #include <SD.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <SpscQueue.hpp>
 
 #include "Configuration.hpp"
 #include "Database.hpp"
+#include "DatabaseQueries.hpp"
 #include "Peripherals.hpp"
 #include "Utils.hpp"
 #include "Infos.hpp"
 #include "RealTime.hpp"
+#include "TimeSeries.hpp"
+#include "Scheduler.hpp"
 
 namespace Database
 {
+    // The storage task does every write on db, Filter and Summary read on their own read-only connection from the
+    // AsyncTCP task. SQLite keeps the pages of an open read statement consistent through the locks of the VFS, which
+    // the SD card one does not take, so access does it: write transactions wait until no read statement is open.
     static sqlite3* db{};
+    static sqlite3* reader{};
+    static SemaphoreHandle_t access{};
+    static size_t readers{};
+    static sqlite3_stmt* insertStatement{};
+    static Configuration::Storage::Engine engine{};
+    static size_t sensorCount{};
+    // Bump whenever the DDL below changes, the low byte of user_version holds the sensor columns created
+    static constexpr int32_t schemaRevision{2};
+    static bool schemaCurrent{};
+
+    static std::array<SensorData, 32> pending{};
+    static size_t pendingFirst{};
+    static size_t pendingCount{};
+    // Batch age on the monotonic clock, setting the date must not commit a batch early or hold it back
+    static std::chrono::steady_clock::time_point pendingSince{};
+
+    struct Rollup
+    {
+        const char* table;
+        std::time_t period;
+        sqlite3_stmt* create;
+        sqlite3_stmt* merge;
+    };
+
+    // Periods are cut on multiples of the epoch value. The clock holds the wall time typed on the configuration page
+    // and no time zone is set, so the daily rollup starts at local midnight.
+    static std::array<Rollup, 2> rollups
+    {
+        {
+            {"SENSORS_DATA_HOURLY", 3600},
+            {"SENSORS_DATA_DAILY", 86400}
+        }
+    };
+    static std::vector<std::string> rollupColumns{};
+    static int64_t backfillNext{};
+    static int64_t backfillLast{};
+
+    static SpscQueue<SensorData, 16> queue{};
+    static TaskHandle_t storageTask{};
+    // Each flush() takes the next ticket and waits until the storage task has served it
+    static std::atomic<uint32_t> flushRequested{0};
+    static std::atomic<uint32_t> flushServed{0};
+    static std::atomic<size_t> queueHighWater{0};
+    static std::atomic<uint32_t> dropped{0};
+    static std::atomic<uint32_t> flushes{0};
 
     auto SensorData::serialize( ArduinoJson::JsonVariant& json ) const -> void
     {
@@ -34,15 +92,60 @@ namespace Database
 
     auto SensorData::get() -> SensorData
     {
-        return
+        const auto snapshot{Infos::Snapshot::get()};
+        auto sensorData{SensorData
         {
             0,
             std::chrono::system_clock::to_time_t( std::chrono::system_clock::now() ),
-            Infos::getTemperature(),
-            Infos::getHumidity(),
-            Infos::getPressure(),
-            { Infos::getSensor( 0 ), Infos::getSensor( 1 ), Infos::getSensor( 2 ) }
-        };
+            snapshot.getTemperature(),
+            snapshot.getHumidity(),
+            snapshot.getPressure(),
+            {}
+        }};
+        sensorData.sensors.reserve( snapshot.count );
+        for ( size_t n{0}; n < snapshot.count; ++n )
+        {
+            sensorData.sensors.push_back( snapshot.getSensor( n ) );
+        }
+        return sensorData;
+    }
+
+    static auto tableColumns( const std::string& table ) -> std::vector<std::string>
+    {
+        auto columns{std::vector<std::string>{}};
+        const auto query{"PRAGMA table_info( " + table + " )"};
+
+        sqlite3_stmt* res;
+        if ( sqlite3_prepare_v2( db, query.data(), query.size(), &res, nullptr ) == SQLITE_OK )
+        {
+            while ( sqlite3_step( res ) == SQLITE_ROW )
+            {
+                columns.emplace_back( reinterpret_cast<const char*>( sqlite3_column_text( res, 1 ) ) );
+            }
+            sqlite3_finalize( res );
+        }
+        return columns;
+    }
+
+    static auto addColumns( const std::string& table, const std::vector<std::string>& columns ) -> void
+    {
+        const auto existing{tableColumns( table )};
+        for ( const auto& column : columns )
+        {
+            if ( std::find( existing.begin(), existing.end(), column ) != existing.end() )
+            {
+                continue;
+            }
+
+            log_d( "adding column %s.%s", table.data(), column.data() );
+            const auto query{DatabaseQueries::addColumn( table, column )};
+            const auto rc{sqlite3_exec( db, query.data(), nullptr, nullptr, nullptr )};
+            if ( rc != SQLITE_OK )
+            {
+                log_e( "column add error: %s\n", sqlite3_errmsg( db ) );
+                std::abort();
+            }
+        }
     }
 
     static auto initializeDatabase() -> void
@@ -51,7 +154,7 @@ namespace Database
 
         sqlite3_initialize();
 
-        const auto rc{sqlite3_open( "/sd/sensors_data.db", &db )};
+        const auto rc{sqlite3_open_v2( "/sd/sensors_data.db", &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, nullptr )};
         if ( rc != SQLITE_OK )
         {
             log_e( "database open error: %s\n", sqlite3_errmsg( db ) );
@@ -61,23 +164,99 @@ namespace Database
         log_d( "end" );
     }
 
+    // Once the schema exists, a read-only connection cannot create it
+    static auto openReader() -> void
+    {
+        const auto rc{sqlite3_open_v2( "/sd/sensors_data.db", &reader, SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX, nullptr )};
+        if ( rc != SQLITE_OK )
+        {
+            log_e( "reader open error: %s\n", sqlite3_errmsg( reader ) );
+            std::abort();
+        }
+        access = xSemaphoreCreateMutex();
+    }
+
+    // Holds access for a write transaction once no read statement is open, giving up after patience
+    static auto beginWrite( std::chrono::milliseconds patience ) -> bool
+    {
+        static constexpr auto poll{std::chrono::milliseconds( 10 )};
+
+        for ( auto waited{std::chrono::milliseconds{0}}; ; waited += poll )
+        {
+            xSemaphoreTake( access, portMAX_DELAY );
+            if ( readers == 0 )
+            {
+                return true;
+            }
+            xSemaphoreGive( access );
+            if ( waited >= patience )
+            {
+                log_d( "read statements open, write postponed" );
+                return false;
+            }
+            vTaskDelay( pdMS_TO_TICKS( poll.count() ) );
+        }
+    }
+
+    static auto endWrite() -> void
+    {
+        xSemaphoreGive( access );
+    }
+
+    // From preparing a read statement to finalizing it
+    static auto beginRead() -> void
+    {
+        xSemaphoreTake( access, portMAX_DELAY );
+        readers++;
+        xSemaphoreGive( access );
+    }
+
+    static auto endRead() -> void
+    {
+        xSemaphoreTake( access, portMAX_DELAY );
+        readers--;
+        xSemaphoreGive( access );
+    }
+
+    static auto schemaVersion() -> int32_t
+    {
+        return schemaRevision << 8 | static_cast<int32_t>( sensorCount );
+    }
+
+    // Skips every CREATE and ALTER when the file was last set up for the same schema and sensors
+    static auto checkSchema() -> void
+    {
+        sqlite3_stmt* res;
+        if ( sqlite3_prepare_v2( db, "PRAGMA user_version", -1, &res, nullptr ) == SQLITE_OK )
+        {
+            if ( sqlite3_step( res ) == SQLITE_ROW )
+            {
+                schemaCurrent = sqlite3_column_int( res, 0 ) == schemaVersion();
+            }
+            sqlite3_finalize( res );
+        }
+        log_d( "schema current = %u", schemaCurrent );
+    }
+
+    static auto updateSchema() -> void
+    {
+        const auto query{"PRAGMA user_version = " + std::to_string( schemaVersion() )};
+        if ( sqlite3_exec( db, query.data(), nullptr, nullptr, nullptr ) != SQLITE_OK )
+        {
+            log_d( "schema version error: %s\n", sqlite3_errmsg( db ) );
+        }
+    }
+
     static auto createTable() -> void
     {
+        if ( schemaCurrent )
+        {
+            return;
+        }
+
         log_d( "begin" );
         {
-            const auto query{"CREATE TABLE IF NOT EXISTS               "
-                             "    SENSORS_DATA (                       "
-                             "        ID          INTEGER PRIMARY KEY, "
-                             "        DATE_TIME   DATETIME,            "
-                             "        TEMPERATURE NUMERIC,             "
-                             "        HUMIDITY    NUMERIC,             "
-                             "        PRESSURE    NUMERIC,             "
-                             "        SENSOR_1    NUMERIC,             "
-                             "        SENSOR_2    NUMERIC,             "
-                             "        SENSOR_3    NUMERIC              "
-                             "    )                                    "};
-
-            const auto rc{sqlite3_exec( db, query, nullptr, nullptr, nullptr )};
+            const auto rc{sqlite3_exec( db, DatabaseQueries::table, nullptr, nullptr, nullptr )};
             if ( rc != SQLITE_OK )
             {
                 log_e( "table create error: %s\n", sqlite3_errmsg( db ) );
@@ -85,10 +264,15 @@ namespace Database
             }
         }
         {
-            const auto query{"CREATE UNIQUE INDEX IF NOT EXISTS DATE_TIME_INDEX "
-                             "ON SENSORS_DATA( DATE_TIME )                      "};
-
-            const auto rc{sqlite3_exec( db, query, nullptr, nullptr, nullptr )};
+            auto columns{std::vector<std::string>{}};
+            for ( size_t n{0}; n < sensorCount; ++n )
+            {
+                columns.push_back( DatabaseQueries::sensorColumn( n ) );
+            }
+            addColumns( "SENSORS_DATA", columns );
+        }
+        {
+            const auto rc{sqlite3_exec( db, DatabaseQueries::index, nullptr, nullptr, nullptr )};
             if ( rc != SQLITE_OK )
             {
                 log_e( "table index error: %s\n", sqlite3_errmsg( db ) );
@@ -98,128 +282,736 @@ namespace Database
         log_d( "end" );
     }
 
-    static auto insert( const SensorData& sensorData ) -> int64_t
+    static auto columnDouble( sqlite3_stmt* res, int column ) -> double
     {
-        const auto query
+        return sqlite3_column_type( res, column ) == SQLITE_NULL ? NAN : sqlite3_column_double( res, column );
+    }
+
+    static auto createRollupTables() -> void
+    {
+        log_d( "begin" );
+
+        rollupColumns = DatabaseQueries::rollupColumns( sensorCount );
+
+        if ( not schemaCurrent )
         {
-            "INSERT INTO SENSORS_DATA ( "
-            "    DATE_TIME,             "
-            "    TEMPERATURE,           "
-            "    HUMIDITY,              "
-            "    PRESSURE,              "
-            "    SENSOR_1,              "
-            "    SENSOR_2,              "
-            "    SENSOR_3               "
-            ")                          "
-            "VALUES                     "
-            "    (?,?,?,?,?,?,?)        "};
+            for ( const auto& rollup : rollups )
+            {
+                const auto query{DatabaseQueries::rollupTable( rollup.table )};
 
-        sqlite3_stmt* res;
-        const auto rc{sqlite3_prepare_v2( db, query, strlen( query ), &res, nullptr )};
+                const auto rc{sqlite3_exec( db, query.data(), nullptr, nullptr, nullptr )};
+                if ( rc != SQLITE_OK )
+                {
+                    log_e( "rollup create error: %s\n", sqlite3_errmsg( db ) );
+                    std::abort();
+                }
+
+                addColumns( rollup.table, DatabaseQueries::rollupAggregates( rollupColumns ) );
+
+                const auto counts{DatabaseQueries::rollupCounts( rollup.table, rollupColumns )};
+                if ( sqlite3_exec( db, counts.data(), nullptr, nullptr, nullptr ) != SQLITE_OK )
+                {
+                    log_e( "rollup count error: %s\n", sqlite3_errmsg( db ) );
+                    std::abort();
+                }
+            }
+            {
+                // Rows present when the rollups are first created are folded in lazily by backfill()
+                const auto query{"CREATE TABLE IF NOT EXISTS                "
+                                 "    ROLLUP_STATE (                        "
+                                 "        ID            INTEGER PRIMARY KEY, "
+                                 "        BACKFILL_NEXT INTEGER,            "
+                                 "        BACKFILL_LAST INTEGER             "
+                                 "    );                                    "
+                                 "INSERT OR IGNORE INTO ROLLUP_STATE        "
+                                 "    SELECT 0, 0, IFNULL( MAX( ID ), 0 )   "
+                                 "    FROM SENSORS_DATA                     "};
+
+                const auto rc{sqlite3_exec( db, query, nullptr, nullptr, nullptr )};
+                if ( rc != SQLITE_OK )
+                {
+                    log_e( "rollup state error: %s\n", sqlite3_errmsg( db ) );
+                    std::abort();
+                }
+            }
+        }
+        {
+            const auto query{"SELECT BACKFILL_NEXT, BACKFILL_LAST FROM ROLLUP_STATE WHERE ID = 0"};
+
+            sqlite3_stmt* res;
+            if ( sqlite3_prepare_v2( db, query, strlen( query ), &res, nullptr ) == SQLITE_OK )
+            {
+                if ( sqlite3_step( res ) == SQLITE_ROW )
+                {
+                    backfillNext = sqlite3_column_int64( res, 0 );
+                    backfillLast = sqlite3_column_int64( res, 1 );
+                }
+                sqlite3_finalize( res );
+            }
+            log_d( "backfill = %lld -> %lld", backfillNext, backfillLast );
+        }
+
+        log_d( "end" );
+    }
+
+    static auto prepareRollups() -> void
+    {
+        log_d( "begin" );
+
+        for ( auto& rollup : rollups )
+        {
+            {
+                const auto query{DatabaseQueries::rollupCreate( rollup.table )};
+
+                const auto rc{sqlite3_prepare_v2( db, query.data(), query.size(), &rollup.create, nullptr )};
+                if ( rc != SQLITE_OK )
+                {
+                    log_e( "rollup prepare error: %s", sqlite3_errmsg( db ) );
+                    std::abort();
+                }
+            }
+            {
+                const auto query{DatabaseQueries::rollupMerge( rollup.table, rollupColumns )};
+
+                const auto rc{sqlite3_prepare_v2( db, query.data(), query.size(), &rollup.merge, nullptr )};
+                if ( rc != SQLITE_OK )
+                {
+                    log_e( "rollup prepare error: %s", sqlite3_errmsg( db ) );
+                    std::abort();
+                }
+            }
+        }
+
+        log_d( "end" );
+    }
+
+    static auto prepareInsert() -> void
+    {
+        log_d( "begin" );
+
+        const auto query{DatabaseQueries::insert( sensorCount )};
+
+        const auto rc{sqlite3_prepare_v2( db, query.data(), query.size(), &insertStatement, nullptr )};
         if ( rc != SQLITE_OK )
         {
-            log_d( "insert prepare error: %s", sqlite3_errmsg( db ) );
-            return 0;
+            log_e( "insert prepare error: %s", sqlite3_errmsg( db ) );
+            std::abort();
         }
 
-        sqlite3_bind_int64( res, 1, sensorData.dateTime );
-        sqlite3_bind_double( res, 2, sensorData.temperature );
-        sqlite3_bind_double( res, 3, sensorData.humidity );
-        sqlite3_bind_double( res, 4, sensorData.pressure );
-        sqlite3_bind_double( res, 5, sensorData.sensors[0] );
-        sqlite3_bind_double( res, 6, sensorData.sensors[1] );
-        sqlite3_bind_double( res, 7, sensorData.sensors[2] );
-        if ( sqlite3_step( res ) != SQLITE_DONE )
+        log_d( "end" );
+    }
+
+    static auto execute( const char* query ) -> bool
+    {
+        const auto rc{sqlite3_exec( db, query, nullptr, nullptr, nullptr )};
+        if ( rc != SQLITE_OK )
+        {
+            log_d( "execute error: %s", sqlite3_errmsg( db ) );
+            return false;
+        }
+        return true;
+    }
+
+    static auto insert( const SensorData& sensorData ) -> int64_t
+    {
+        sqlite3_bind_int64( insertStatement, 1, sensorData.dateTime );
+        sqlite3_bind_double( insertStatement, 2, sensorData.temperature );
+        sqlite3_bind_double( insertStatement, 3, sensorData.humidity );
+        sqlite3_bind_double( insertStatement, 4, sensorData.pressure );
+        for ( size_t n{0}; n < sensorCount; ++n )
+        {
+            if ( n < sensorData.sensors.size() )
+            {
+                sqlite3_bind_double( insertStatement, 5 + n, sensorData.sensors[n] );
+            }
+            else
+            {
+                sqlite3_bind_null( insertStatement, 5 + n );
+            }
+        }
+        if ( sqlite3_step( insertStatement ) != SQLITE_DONE )
         {
             log_d( "insert error: %s", sqlite3_errmsg( db ) );
-            //std::abort();
+            sqlite3_reset( insertStatement );
+            return 0;
         }
-        sqlite3_finalize( res );
+        sqlite3_reset( insertStatement );
         return sqlite3_last_insert_rowid( db );
     }
 
+    static auto accumulate( const Rollup& rollup, std::time_t dateTime, int64_t count, const std::vector<Aggregate>& aggregates ) -> void
+    {
+        const auto period{dateTime - dateTime % rollup.period};
+
+        sqlite3_bind_int64( rollup.create, 1, period );
+        if ( sqlite3_step( rollup.create ) != SQLITE_DONE )
+        {
+            log_d( "rollup create error: %s", sqlite3_errmsg( db ) );
+        }
+        sqlite3_reset( rollup.create );
+
+        sqlite3_bind_int64( rollup.merge, 1, period );
+        sqlite3_bind_int64( rollup.merge, 2, count );
+        for ( size_t n{0}; n < aggregates.size(); ++n )
+        {
+            sqlite3_bind_double( rollup.merge, 3 + n * 4, aggregates[n].min );
+            sqlite3_bind_double( rollup.merge, 4 + n * 4, aggregates[n].max );
+            sqlite3_bind_double( rollup.merge, 5 + n * 4, aggregates[n].sum );
+            sqlite3_bind_int64( rollup.merge, 6 + n * 4, aggregates[n].count );
+        }
+        if ( sqlite3_step( rollup.merge ) != SQLITE_DONE )
+        {
+            log_d( "rollup merge error: %s", sqlite3_errmsg( db ) );
+        }
+        sqlite3_reset( rollup.merge );
+    }
+
+    // NAN is bound as NULL and not counted
+    static auto single( double value ) -> Aggregate
+    {
+        return Aggregate{value, value, value, std::isnan( value ) ? 0 : 1};
+    }
+
+    static auto accumulate( const SensorData& sensorData ) -> void
+    {
+        auto aggregates{std::vector<Aggregate>( rollupColumns.size(), single( NAN ) )};
+        aggregates[0] = single( sensorData.temperature );
+        aggregates[1] = single( sensorData.humidity );
+        aggregates[2] = single( sensorData.pressure );
+        for ( size_t n{0}; n < sensorData.sensors.size() and 3 + n < aggregates.size(); ++n )
+        {
+            aggregates[3 + n] = single( sensorData.sensors[n] );
+        }
+
+        for ( const auto& rollup : rollups )
+        {
+            accumulate( rollup, sensorData.dateTime, 1, aggregates );
+        }
+    }
+
+    static auto backfill() -> void
+    {
+        static constexpr int64_t chunk{288};
+
+        if ( backfillNext >= backfillLast )
+        {
+            return;
+        }
+
+        const auto last{std::min( backfillNext + chunk, backfillLast )};
+
+        if ( not beginWrite( std::chrono::milliseconds( 0 ) ) )
+        {
+            return;
+        }
+        if ( not execute( "BEGIN TRANSACTION" ) )
+        {
+            endWrite();
+            return;
+        }
+
+        for ( const auto& rollup : rollups )
+        {
+            const auto query{DatabaseQueries::rollupBackfill( rollupColumns )};
+
+            sqlite3_stmt* res;
+            if ( sqlite3_prepare_v2( db, query.data(), query.size(), &res, nullptr ) != SQLITE_OK )
+            {
+                log_d( "backfill prepare error: %s", sqlite3_errmsg( db ) );
+                execute( "ROLLBACK TRANSACTION" );
+                endWrite();
+                return;
+            }
+
+            sqlite3_bind_int64( res, 1, backfillNext );
+            sqlite3_bind_int64( res, 2, last );
+            sqlite3_bind_int64( res, 3, rollup.period );
+            while ( sqlite3_step( res ) == SQLITE_ROW )
+            {
+                auto aggregates{std::vector<Aggregate>( rollupColumns.size() )};
+                for ( size_t n{0}; n < aggregates.size(); ++n )
+                {
+                    aggregates[n] = Aggregate{columnDouble( res, 2 + n * 4 ), columnDouble( res, 3 + n * 4 ), columnDouble( res, 4 + n * 4 ), sqlite3_column_int64( res, 5 + n * 4 )};
+                }
+                accumulate( rollup, sqlite3_column_int64( res, 0 ), sqlite3_column_int64( res, 1 ), aggregates );
+            }
+            sqlite3_finalize( res );
+        }
+
+        {
+            const auto query{"UPDATE ROLLUP_STATE SET BACKFILL_NEXT = ?1 WHERE ID = 0"};
+
+            sqlite3_stmt* res;
+            if ( sqlite3_prepare_v2( db, query, strlen( query ), &res, nullptr ) == SQLITE_OK )
+            {
+                sqlite3_bind_int64( res, 1, last );
+                sqlite3_step( res );
+                sqlite3_finalize( res );
+            }
+        }
+
+        if ( not execute( "COMMIT TRANSACTION" ) )
+        {
+            execute( "ROLLBACK TRANSACTION" );
+            endWrite();
+            return;
+        }
+        endWrite();
+
+        log_d( "backfill = %lld -> %lld", last, backfillLast );
+        backfillNext = last;
+    }
+
+    static auto enqueue( const SensorData& sensorData ) -> void
+    {
+        if ( pendingCount == pending.size() )
+        {
+            log_d( "batch full, dropping oldest sample" );
+            pendingFirst = ( pendingFirst + 1 ) % pending.size();
+            pendingCount--;
+        }
+        if ( pendingCount == 0 )
+        {
+            pendingSince = std::chrono::steady_clock::now();
+        }
+        pending[( pendingFirst + pendingCount ) % pending.size()] = sensorData;
+        pendingCount++;
+    }
+
+    // Waits up to patience for the open read statements, a batch that cannot be written now stays pending
+    static auto commit( std::chrono::milliseconds patience ) -> void
+    {
+        if ( pendingCount == 0 )
+        {
+            return;
+        }
+
+        if ( not beginWrite( patience ) )
+        {
+            return;
+        }
+        if ( not execute( "BEGIN TRANSACTION" ) )
+        {
+            endWrite();
+            return;
+        }
+
+        const auto compressed{engine == Configuration::Storage::Engine::Compressed};
+        for ( size_t n{0}; n < pendingCount; ++n )
+        {
+            const auto& sensorData{pending[( pendingFirst + n ) % pending.size()]};
+            if ( compressed or insert( sensorData ) != 0 )
+            {
+                accumulate( sensorData );
+            }
+        }
+
+        if ( not execute( "COMMIT TRANSACTION" ) )
+        {
+            execute( "ROLLBACK TRANSACTION" );
+            endWrite();
+            return;
+        }
+        endWrite();
+
+        // Compressed blocks cannot be rolled back, so they only take the samples once their rollups are committed.
+        // A failed COMMIT is then retried with the same batch without appending anything twice.
+        if ( compressed )
+        {
+            for ( size_t n{0}; n < pendingCount; ++n )
+            {
+                if ( TimeSeries::append( pending[( pendingFirst + n ) % pending.size()] ) == 0 )
+                {
+                    log_e( "compressed append error, sample lost" );
+                }
+            }
+            TimeSeries::sync();
+        }
+
+        log_d( "committed %u samples", pendingCount );
+
+        pendingFirst = ( pendingFirst + pendingCount ) % pending.size();
+        pendingCount = 0;
+        flushes++;
+    }
+
+    static auto check() -> void
+    {
+        if ( pendingCount == 0 )
+        {
+            return;
+        }
+
+        // The loop task replaces cfg when a configuration is applied, the storage task reads it through the lock
+        const auto storage{Configuration::get().storage};
+        const auto batchSize{std::min<size_t>( std::max<uint16_t>( storage.batchSize, 1 ), pending.size() )};
+        const auto batchAge{std::chrono::seconds( storage.batchAge )};
+        if ( pendingCount >= batchSize or std::chrono::steady_clock::now() - pendingSince >= batchAge )
+        {
+            commit( std::chrono::milliseconds( 0 ) );
+        }
+    }
+
+    static auto storage( void* ) -> void
+    {
+        log_d( "begin" );
+
+        while ( true )
+        {
+            ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( 1000 ) );
+
+            // Read before draining the queue, samples pushed before a flush() are then part of the commit serving it
+            const auto requested{flushRequested.load()};
+
+            auto sensorData{SensorData{}};
+            while ( queue.pop( &sensorData ) )
+            {
+                enqueue( sensorData );
+            }
+
+            if ( requested != flushServed.load() )
+            {
+                // Within the wait of flush(), a page still downloading would otherwise hold the samples back
+                commit( std::chrono::milliseconds( 5000 ) );
+                flushServed = requested;
+            }
+            else
+            {
+                check();
+                backfill();
+            }
+        }
+    }
+
     static auto generate() -> void
     {
-        insert( SensorData::get() );
+        if ( not queue.push( SensorData::get() ) )
+        {
+            dropped++;
+            log_d( "storage queue full, sample dropped" );
+        }
+
+        const auto depth{queue.size()};
+        if ( depth > queueHighWater )
+        {
+            queueHighWater = depth;
+        }
+
+        xTaskNotifyGive( storageTask );
+    }
+
+    // Batching is read through Configuration::get() by the storage task, the engine and the table columns are fixed until a restart
+    static auto reconfigure( const Configuration& previous ) -> bool
+    {
+        return cfg.storage.engine == previous.storage.engine and cfg.sensors.size() == previous.sensors.size();
     }
 
     auto init() -> void
     {
         log_d( "begin" );
 
+        engine = cfg.storage.engine;
+        sensorCount = cfg.sensors.size();
+
         initializeDatabase();
+        checkSchema();
         createTable();
+        createRollupTables();
+        updateSchema();
+        prepareInsert();
+        prepareRollups();
+        openReader();
+
+        if ( engine == Configuration::Storage::Engine::Compressed )
+        {
+            TimeSeries::init();
+        }
+
+        xTaskCreatePinnedToCore( Database::storage, "storage", 10240, nullptr, 1, &storageTask, 0 );
+
+        Scheduler::bound( std::chrono::minutes( 5 ), Database::generate );
+        Configuration::onChange( Database::reconfigure );
 
         log_d( "end" );
     }
 
-    auto process() -> void
+    auto append( const SensorData& sensorData ) -> void
     {
-        Utils::bound( std::chrono::minutes( 5 ), Database::generate );
+        while ( not queue.push( sensorData ) )
+        {
+            xTaskNotifyGive( storageTask );
+            vTaskDelay( pdMS_TO_TICKS( 10 ) );
+        }
+        xTaskNotifyGive( storageTask );
     }
 
-    Filter::Filter( int64_t id, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end )
+    auto flush() -> void
     {
-        const auto query
+        static constexpr uint32_t timeout{10000};
+        static constexpr uint32_t poll{10};
+
+        const auto ticket{++flushRequested};
+        xTaskNotifyGive( storageTask );
+
+        // A commit still running for an earlier flush that timed out carries an older ticket and does not end this wait
+        for ( uint32_t waited{0}; static_cast<int32_t>( flushServed.load() - ticket ) < 0; waited += poll )
         {
-            "SELECT                                       "
-            "    ID,                                      "
-            "    DATE_TIME,                               "
-            "    TEMPERATURE,                             "
-            "    HUMIDITY,                                "
-            "    PRESSURE,                                "
-            "    SENSOR_1,                                "
-            "    SENSOR_2,                                "
-            "    SENSOR_3                                 "
-            "FROM                                         "
-            "    SENSORS_DATA                             "
-            "WHERE                                        "
-            "        ( ID >= IFNULL(?,ID) )               "
-            "    AND ( DATE_TIME >= IFNULL(?,DATE_TIME) ) "
-            "    AND ( DATE_TIME <= IFNULL(?,DATE_TIME) ) "
-            "ORDER BY                                     "
-            "    DATE_TIME ASC                            "};
+            if ( waited >= timeout )
+            {
+                log_d( "flush timeout" );
+                return;
+            }
+            vTaskDelay( pdMS_TO_TICKS( poll ) );
+        }
+    }
 
-        const auto rc{sqlite3_prepare_v2( db, query, strlen( query ), &this->res, nullptr )};
-        if ( rc != SQLITE_OK )
+    auto SummaryData::serialize( ArduinoJson::JsonVariant& json ) const -> void
+    {
+        const auto add{[this]( ArduinoJson::JsonArray json, const Aggregate & aggregate )
         {
-            log_d( "select prepare error: %s", sqlite3_errmsg( db ) );
-            this->res = nullptr;
+            json.add( aggregate.min );
+            json.add( aggregate.count > 0 ? aggregate.sum / aggregate.count : NAN );
+            json.add( aggregate.max );
+        }};
+
+        json["datetime"] = Utils::DateTime::toString( std::chrono::system_clock::from_time_t( this->dateTime ) );
+        json["count"] = this->count;
+        add( json.createNestedArray( "temperature" ), this->temperature );
+        add( json.createNestedArray( "humidity" ), this->humidity );
+        add( json.createNestedArray( "pressure" ), this->pressure );
+        {
+            auto sensors{json.createNestedArray( "sensors" )};
+            for ( const auto& sensor : this->sensors )
+            {
+                add( sensors.createNestedArray(), sensor );
+            }
         }
-        else
+    }
+
+    auto Statistics::get() -> Statistics
+    {
+        return
+        {
+            Database::queue.size(),
+            Database::queue.capacity(),
+            Database::queueHighWater,
+            Database::dropped,
+            Database::flushes
+        };
+    }
+
+    auto Statistics::serialize( ArduinoJson::JsonVariant& json ) const -> void
+    {
+        json["queue_depth"] = this->queueDepth;
+        json["queue_capacity"] = this->queueCapacity;
+        json["queue_high_water"] = this->queueHighWater;
+        json["dropped"] = this->dropped;
+        json["flushes"] = this->flushes;
+    }
+
+    auto Cursor::fromString( const std::string& str ) -> Cursor
+    {
+        auto cursor{Cursor{}};
+        auto separator{size_t{}};
+        if ( ( separator = str.find( '-' ) ) != std::string::npos )
         {
-            if ( id != int64_t{} )
+            cursor.dateTime = std::strtoll( str.substr( 0, separator ).data(), nullptr, 16 );
+            cursor.id = std::strtoll( str.substr( separator + 1 ).data(), nullptr, 16 );
+        }
+        return cursor;
+    }
+
+    auto Cursor::toString() const -> std::string
+    {
+        char buffer[40];
+        std::snprintf( buffer, sizeof( buffer ), "%llx-%llx", static_cast<long long>( this->dateTime ), static_cast<long long>( this->id ) );
+        return buffer;
+    }
+
+    Cursor::operator bool() const
+    {
+        return this->id != std::int64_t{};
+    }
+
+    class Statement : public Source
+    {
+        private:
+            sqlite3_stmt* res;
+        public:
+            Statement( int64_t id, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, Cursor after, size_t limit )
             {
-                sqlite3_bind_int64( this->res, 1, id );
+                const auto byId{id != int64_t{}};
+                const auto byStart{start != std::chrono::system_clock::time_point::min()};
+                const auto byEnd{end != std::chrono::system_clock::time_point::max()};
+
+                const auto byAfter{static_cast<bool>( after )};
+
+                const auto query{DatabaseQueries::select( sensorCount, byId, byStart, byEnd, byAfter )};
+
+                beginRead();
+                const auto rc{sqlite3_prepare_v2( reader, query.data(), query.size(), &this->res, nullptr )};
+                if ( rc != SQLITE_OK )
+                {
+                    log_d( "select prepare error: %s", sqlite3_errmsg( reader ) );
+                    this->res = nullptr;
+                    endRead();
+                }
+                else
+                {
+                    if ( byId )
+                    {
+                        sqlite3_bind_int64( this->res, 1, id );
+                    }
+                    if ( byStart )
+                    {
+                        sqlite3_bind_int64( this->res, 2, std::chrono::system_clock::to_time_t( start ) );
+                    }
+                    if ( byEnd )
+                    {
+                        sqlite3_bind_int64( this->res, 3, std::chrono::system_clock::to_time_t( end ) );
+                    }
+                    if ( byAfter )
+                    {
+                        sqlite3_bind_int64( this->res, 4, after.dateTime );
+                        sqlite3_bind_int64( this->res, 5, after.id );
+                    }
+                    sqlite3_bind_int64( this->res, 6, limit > 0 ? static_cast<int64_t>( limit ) : -1 );
+                }
             }
-            if ( start != std::chrono::system_clock::time_point::min() )
+
+            ~Statement() override
             {
-                sqlite3_bind_int64( this->res, 2, std::chrono::system_clock::to_time_t( start ) );
+                if( this->res != nullptr )
+                {
+                    sqlite3_finalize( this->res );
+                    this->res = nullptr;
+                    endRead();
+                }
             }
-            if ( end != std::chrono::system_clock::time_point::max() )
+
+            auto next( SensorData* sensorData ) -> bool override
             {
-                sqlite3_bind_int64( this->res, 3, std::chrono::system_clock::to_time_t( end ) );
+                if ( this->res == nullptr )
+                {
+                    return false;
+                }
+
+                if( sqlite3_step( this->res ) != SQLITE_ROW )
+                {
+                    return false;
+                }
+
+                sensorData->id = sqlite3_column_int64( this->res, 0 );
+                sensorData->dateTime = sqlite3_column_int64( this->res, 1 );
+                sensorData->temperature = sqlite3_column_double( this->res, 2 );
+                sensorData->humidity = sqlite3_column_double( this->res, 3 );
+                sensorData->pressure = sqlite3_column_double( this->res, 4 );
+                sensorData->sensors.resize( sensorCount );
+                for ( size_t n{0}; n < sensorCount; ++n )
+                {
+                    sensorData->sensors[n] = columnDouble( this->res, 5 + n );
+                }
+                return true;
             }
+    };
+
+    Filter::Filter( int64_t id, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, Cursor after, size_t limit )
+    {
+        if ( engine == Configuration::Storage::Engine::Compressed )
+        {
+            this->source = TimeSeries::select( id, start, end, after, limit );
+        }
+        else
+        {
+            this->source = std::unique_ptr<Source> { new Statement{id, start, end, after, limit} };
         }
     }
 
-    Filter::Filter( Filter&& other )
+    Summary::Summary( std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, size_t points )
+    {
+        static constexpr std::time_t sampleInterval{300};
+
+        const auto first{std::chrono::system_clock::to_time_t( start )};
+        const auto last{std::chrono::system_clock::to_time_t( end )};
+        const auto span{std::max<std::time_t>( last - first, 0 )};
+        points = std::max<size_t>( points, 1 );
+
+        this->res = nullptr;
+        if ( span / sampleInterval <= points )
+        {
+            // Raw samples come from whichever engine holds them
+            this->resolution = Resolution::Raw;
+            this->raw = std::unique_ptr<Filter> { new Filter{0, start, end} };
+            return;
+        }
+
+        const auto& rollup{span / rollups[0].period <= points ? rollups[0] : rollups[1]};
+        this->resolution = &rollup == &rollups[0] ? Resolution::Hourly : Resolution::Daily;
+        const auto period{rollup.period};
+
+        const auto query{DatabaseQueries::rollupSelect( rollup.table, rollupColumns )};
+
+        beginRead();
+        const auto rc{sqlite3_prepare_v2( reader, query.data(), query.size(), &this->res, nullptr )};
+        if ( rc != SQLITE_OK )
+        {
+            log_d( "summary prepare error: %s", sqlite3_errmsg( reader ) );
+            this->res = nullptr;
+            endRead();
+        }
+        else
+        {
+            sqlite3_bind_int64( this->res, 1, first - first % period );
+            sqlite3_bind_int64( this->res, 2, last );
+        }
+    }
+
+    Summary::Summary( Summary&& other )
     {
         this->res = other.res;
+        this->raw = std::move( other.raw );
+        this->resolution = other.resolution;
         other.res = nullptr;
     }
 
-    Filter::~Filter()
+    Summary::~Summary()
     {
         if( this->res != nullptr )
         {
             sqlite3_finalize( this->res );
             this->res = nullptr;
+            endRead();
         }
     }
 
-    auto Filter::next( SensorData* sensorData ) const -> bool
+    auto Summary::getResolution() const -> Resolution
+    {
+        return this->resolution;
+    }
+
+    auto Summary::next( SummaryData* summaryData ) const -> bool
     {
+        if ( this->raw != nullptr )
+        {
+            auto sensorData{SensorData{}};
+            if ( not this->raw->next( &sensorData ) )
+            {
+                return false;
+            }
+
+            summaryData->dateTime = sensorData.dateTime;
+            summaryData->count = 1;
+            summaryData->temperature = single( sensorData.temperature );
+            summaryData->humidity = single( sensorData.humidity );
+            summaryData->pressure = single( sensorData.pressure );
+            summaryData->sensors.resize( sensorData.sensors.size() );
+            for ( size_t n{0}; n < sensorData.sensors.size(); ++n )
+            {
+                summaryData->sensors[n] = single( sensorData.sensors[n] );
+            }
+            return true;
+        }
+
         if ( this->res == nullptr )
         {
             return false;
@@ -230,14 +1022,45 @@ namespace Database
             return false;
         }
 
-        sensorData->id = sqlite3_column_int64( this->res, 0 );
-        sensorData->dateTime = sqlite3_column_int64( this->res, 1 );
-        sensorData->temperature = sqlite3_column_double( this->res, 2 );
-        sensorData->humidity = sqlite3_column_double( this->res, 3 );
-        sensorData->pressure = sqlite3_column_double( this->res, 4 );
-        sensorData->sensors[0] = sqlite3_column_double( this->res, 5 );
-        sensorData->sensors[1] = sqlite3_column_double( this->res, 6 );
-        sensorData->sensors[2] = sqlite3_column_double( this->res, 7 );
+        const auto aggregate{[this]( int column ) -> Aggregate
+        {
+            return { columnDouble( this->res, column ), columnDouble( this->res, column + 1 ), columnDouble( this->res, column + 2 ), sqlite3_column_int64( this->res, column + 3 ) };
+        }};
+
+        summaryData->dateTime = sqlite3_column_int64( this->res, 0 );
+        summaryData->count = sqlite3_column_int64( this->res, 1 );
+        summaryData->temperature = aggregate( 2 );
+        summaryData->humidity = aggregate( 6 );
+        summaryData->pressure = aggregate( 10 );
+        summaryData->sensors.resize( sensorCount );
+        for ( size_t n{0}; n < sensorCount; ++n )
+        {
+            summaryData->sensors[n] = aggregate( 14 + n * 4 );
+        }
+        return true;
+    }
+
+    Filter::Filter( Filter&& other )
+    {
+        this->source = std::move( other.source );
+    }
+
+    Filter::~Filter() = default;
+
+    auto Filter::next( SensorData* sensorData ) const -> bool
+    {
+        if ( this->source == nullptr )
+        {
+            return false;
+        }
+
+        if ( not this->source->next( sensorData ) )
+        {
+            return false;
+        }
+
+        // Rows written before a sensor was added read it as NAN
+        sensorData->sensors.resize( sensorCount, NAN );
         return true;
     }
-} // namespace Database
\ No newline at end of file
+} // namespace Database
@@ -4,6 +4,8 @@
 #include <ArduinoJson.hpp>
 #include <functional>
 #include <chrono>
+#include <memory>
+#include <vector>
 #include <sqlite3.h>
 
 namespace Database
@@ -15,18 +17,69 @@ namespace Database
         double temperature;
         double humidity;
         double pressure;
-        std::array<double, 3> sensors;
+        std::vector<double> sensors;
 
         static auto get() -> SensorData;
         auto serialize ( ArduinoJson::JsonVariant& json ) const -> void;
     };
 
+    struct Aggregate
+    {
+        double min;
+        double max;
+        double sum;
+        // Samples where the column was not NULL, the average divides by it rather than by the period count
+        std::int64_t count;
+    };
+
+    struct SummaryData
+    {
+        std::time_t dateTime;
+        std::int64_t count;
+        Aggregate temperature;
+        Aggregate humidity;
+        Aggregate pressure;
+        std::vector<Aggregate> sensors;
+
+        auto serialize ( ArduinoJson::JsonVariant& json ) const -> void;
+    };
+
+    struct Statistics
+    {
+        size_t queueDepth;
+        size_t queueCapacity;
+        size_t queueHighWater;
+        uint32_t dropped;
+        uint32_t flushes;
+
+        static auto get() -> Statistics;
+        auto serialize ( ArduinoJson::JsonVariant& json ) const -> void;
+    };
+
+    struct Cursor
+    {
+        std::time_t dateTime;
+        std::int64_t id;
+
+        static auto fromString( const std::string& str ) -> Cursor;
+        auto toString() const -> std::string;
+        explicit operator bool() const;
+    };
+
+    // Row iterator implemented by each storage engine
+    class Source
+    {
+        public:
+            virtual ~Source() = default;
+            virtual auto next( SensorData* sensorData ) -> bool = 0;
+    };
+
     class Filter
     {
         private:
-            sqlite3_stmt* res;
+            std::unique_ptr<Source> source;
         public:
-            Filter( int64_t id = 0, std::chrono::system_clock::time_point start = std::chrono::system_clock::time_point::min(), std::chrono::system_clock::time_point end = std::chrono::system_clock::time_point::max() );
+            Filter( int64_t id = 0, std::chrono::system_clock::time_point start = std::chrono::system_clock::time_point::min(), std::chrono::system_clock::time_point end = std::chrono::system_clock::time_point::max(), Cursor after = Cursor{}, size_t limit = 0 );
             Filter( Filter& ) = delete;
             Filter( Filter&& );
             ~Filter();
@@ -34,6 +87,31 @@ namespace Database
             auto next( SensorData* sensorData ) const -> bool;
     };
 
+    class Summary
+    {
+        public:
+            enum Resolution
+            {
+                Raw,
+                Hourly,
+                Daily
+            };
+        private:
+            sqlite3_stmt* res;
+            std::unique_ptr<Filter> raw;
+            Resolution resolution;
+        public:
+            Summary( std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, size_t points );
+            Summary( Summary& ) = delete;
+            Summary( Summary&& );
+            ~Summary();
+
+            auto getResolution() const -> Resolution;
+            auto next( SummaryData* summaryData ) const -> bool;
+    };
+
     auto init() -> void;
-    auto process() -> void;
+    auto flush() -> void;
+    // Stores a sample taken elsewhere, waiting for room in the storage queue instead of dropping it
+    auto append( const SensorData& sensorData ) -> void;
 } // namespace Database
\ No newline at end of file
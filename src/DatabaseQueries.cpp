@@ -0,0 +1,192 @@
+#include "DatabaseQueries.hpp"
+
+namespace DatabaseQueries
+{
+    const char* const table{"CREATE TABLE IF NOT EXISTS               "
+                            "    SENSORS_DATA (                       "
+                            "        ID          INTEGER PRIMARY KEY, "
+                            "        DATE_TIME   DATETIME,            "
+                            "        TEMPERATURE NUMERIC,             "
+                            "        HUMIDITY    NUMERIC,             "
+                            "        PRESSURE    NUMERIC              "
+                            "    )                                    "};
+
+    const char* const index{"CREATE UNIQUE INDEX IF NOT EXISTS DATE_TIME_INDEX "
+                            "ON SENSORS_DATA( DATE_TIME )                      "};
+
+    auto sensorColumn( size_t index ) -> std::string
+    {
+        return "SENSOR_" + std::to_string( index + 1 );
+    }
+
+    // Sensors added to the configuration become new nullable columns, rows stored before keep NULL in them
+    auto addColumn( const std::string& table, const std::string& column ) -> std::string
+    {
+        return "ALTER TABLE " + table + " ADD COLUMN " + column + " NUMERIC";
+    }
+
+    auto insert( size_t sensorCount ) -> std::string
+    {
+        auto query{std::string{"INSERT INTO SENSORS_DATA ( DATE_TIME, TEMPERATURE, HUMIDITY, PRESSURE"}};
+        auto values{std::string{"?,?,?,?"}};
+        for ( size_t n{0}; n < sensorCount; ++n )
+        {
+            query += ", " + sensorColumn( n );
+            values += ",?";
+        }
+        query += " ) VALUES ( " + values + " )";
+        return query;
+    }
+
+    auto select( size_t sensorCount, bool byId, bool byStart, bool byEnd, bool byAfter ) -> std::string
+    {
+        auto query
+        {
+            std::string{
+                "SELECT                    "
+                "    ID,                   "
+                "    DATE_TIME,            "
+                "    TEMPERATURE,          "
+                "    HUMIDITY,             "
+                "    PRESSURE              "}
+        };
+        for ( size_t n{0}; n < sensorCount; ++n )
+        {
+            query += ", " + sensorColumn( n ) + " ";
+        }
+        query += "FROM                      "
+                 "    SENSORS_DATA          ";
+
+        // Only the predicates that are actually set are emitted, so each combination is a plain range SQLite can seek on
+        auto separator{"WHERE                     "};
+        if ( byId )
+        {
+            query += separator;
+            query += "    ( ID >= ?1 )          ";
+            separator = "    AND                   ";
+        }
+        if ( byStart )
+        {
+            query += separator;
+            query += "    ( DATE_TIME >= ?2 )   ";
+            separator = "    AND                   ";
+        }
+        if ( byEnd )
+        {
+            query += separator;
+            query += "    ( DATE_TIME <= ?3 )   ";
+            separator = "    AND                   ";
+        }
+        if ( byAfter )
+        {
+            query += separator;
+            query += "    ( ( DATE_TIME, ID ) > ( ?4, ?5 ) ) ";
+        }
+
+        // Rows are appended in time order, so an id alone seeks on the rowid and reads in the same order. Otherwise
+        // DATE_TIME_INDEX entries end with the rowid, so this order is the index order and never needs a sort
+        if ( byId and not byStart and not byEnd and not byAfter )
+        {
+            query += "ORDER BY                  "
+                     "    ID ASC                ";
+        }
+        else
+        {
+            query += "ORDER BY                  "
+                     "    DATE_TIME ASC,        "
+                     "    ID ASC                ";
+        }
+        query += "LIMIT                     "
+                 "    ?6                    ";
+
+        return query;
+    }
+
+    auto rollupColumns( size_t sensorCount ) -> std::vector<std::string>
+    {
+        auto columns{std::vector<std::string>{"TEMPERATURE", "HUMIDITY", "PRESSURE"}};
+        for ( size_t n{0}; n < sensorCount; ++n )
+        {
+            columns.push_back( sensorColumn( n ) );
+        }
+        return columns;
+    }
+
+    auto rollupTable( const char* table ) -> std::string
+    {
+        return std::string{"CREATE TABLE IF NOT EXISTS "} + table + " ( PERIOD INTEGER PRIMARY KEY, COUNT INTEGER )";
+    }
+
+    auto rollupAggregates( const std::vector<std::string>& columns ) -> std::vector<std::string>
+    {
+        auto aggregates{std::vector<std::string>{}};
+        for ( const auto& column : columns )
+        {
+            aggregates.push_back( column + "_MIN" );
+            aggregates.push_back( column + "_MAX" );
+            aggregates.push_back( column + "_SUM" );
+            aggregates.push_back( column + "_COUNT" );
+        }
+        return aggregates;
+    }
+
+    // Exact for periods where a column was always or never set, a sensor added in the middle of a period
+    // is averaged over the whole period as before
+    auto rollupCounts( const char* table, const std::vector<std::string>& columns ) -> std::string
+    {
+        auto query{std::string{"UPDATE "} + table + " SET "};
+        for ( size_t n{0}; n < columns.size(); ++n )
+        {
+            const auto& column{columns[n]};
+            query += n > 0 ? ", " : "";
+            query += column + "_COUNT = IFNULL( " + column + "_COUNT, CASE WHEN " + column + "_MIN IS NULL THEN 0 ELSE COUNT END )";
+        }
+        return query;
+    }
+
+    auto rollupCreate( const char* table ) -> std::string
+    {
+        return std::string{"INSERT OR IGNORE INTO "} + table + " ( PERIOD, COUNT ) VALUES ( ?1, 0 )";
+    }
+
+    auto rollupMerge( const char* table, const std::vector<std::string>& columns ) -> std::string
+    {
+        auto query{std::string{"UPDATE "} + table + " SET COUNT = COUNT + ?2"};
+        for ( size_t n{0}; n < columns.size(); ++n )
+        {
+            const auto& column{columns[n]};
+            const auto min{"?" + std::to_string( 3 + n * 4 )};
+            const auto max{"?" + std::to_string( 4 + n * 4 )};
+            const auto sum{"?" + std::to_string( 5 + n * 4 )};
+            const auto count{"?" + std::to_string( 6 + n * 4 )};
+            query += ", " + column + "_MIN = MIN( IFNULL( " + column + "_MIN, " + min + " ), IFNULL( " + min + ", " + column + "_MIN ) )";
+            query += ", " + column + "_MAX = MAX( IFNULL( " + column + "_MAX, " + max + " ), IFNULL( " + max + ", " + column + "_MAX ) )";
+            query += ", " + column + "_SUM = IFNULL( " + column + "_SUM, 0 ) + IFNULL( " + sum + ", 0 )";
+            query += ", " + column + "_COUNT = IFNULL( " + column + "_COUNT, 0 ) + " + count;
+        }
+        query += " WHERE PERIOD = ?1";
+        return query;
+    }
+
+    auto rollupBackfill( const std::vector<std::string>& columns ) -> std::string
+    {
+        auto query{std::string{"SELECT DATE_TIME, COUNT(*)"}};
+        for ( const auto& column : columns )
+        {
+            query += ", MIN( " + column + " ), MAX( " + column + " ), TOTAL( " + column + " ), COUNT( " + column + " )";
+        }
+        query += " FROM SENSORS_DATA WHERE ID > ?1 AND ID <= ?2 GROUP BY DATE_TIME - DATE_TIME % ?3";
+        return query;
+    }
+
+    auto rollupSelect( const char* table, const std::vector<std::string>& columns ) -> std::string
+    {
+        auto query{std::string{"SELECT PERIOD, COUNT"}};
+        for ( const auto& column : columns )
+        {
+            query += ", " + column + "_MIN, " + column + "_MAX, " + column + "_SUM, " + column + "_COUNT";
+        }
+        query += std::string{" FROM "} + table + " WHERE PERIOD >= ?1 AND PERIOD <= ?2 ORDER BY PERIOD ASC";
+        return query;
+    }
+} // namespace DatabaseQueries
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// SQL text of the SENSORS_DATA schema and its queries, kept apart from Database.cpp so the host tests run the same statements
+namespace DatabaseQueries
+{
+    extern const char* const table;
+    extern const char* const index;
+
+    // Sensors are stored one column each, SENSOR_1 being the first configured sensor
+    auto sensorColumn( size_t index ) -> std::string;
+    auto addColumn( const std::string& table, const std::string& column ) -> std::string;
+
+    auto insert( size_t sensorCount ) -> std::string;
+    // Binds ?1 id, ?2 start, ?3 end, ?4 ?5 cursor date time and id, ?6 limit
+    auto select( size_t sensorCount, bool byId, bool byStart, bool byEnd, bool byAfter ) -> std::string;
+
+    // TEMPERATURE, HUMIDITY, PRESSURE then the sensors, each aggregated as <COLUMN>_MIN, _MAX, _SUM and _COUNT,
+    // the last counting the samples where the column was not NULL
+    auto rollupColumns( size_t sensorCount ) -> std::vector<std::string>;
+    auto rollupTable( const char* table ) -> std::string;
+    auto rollupAggregates( const std::vector<std::string>& columns ) -> std::vector<std::string>;
+    // Fills the _COUNT columns added to rollups written before they existed
+    auto rollupCounts( const char* table, const std::vector<std::string>& columns ) -> std::string;
+    // Binds ?1 period
+    auto rollupCreate( const char* table ) -> std::string;
+    // Binds ?1 period, ?2 sample count, then min, max, sum and count of each column from ?3
+    auto rollupMerge( const char* table, const std::vector<std::string>& columns ) -> std::string;
+    // Binds ?1 ?2 the id range, ?3 the period, rows are date time, count, then min, max, total and count of each column
+    auto rollupBackfill( const std::vector<std::string>& columns ) -> std::string;
+    // Binds ?1 ?2 the period range, rows are period, count, then min, max, sum and count of each column
+    auto rollupSelect( const char* table, const std::vector<std::string>& columns ) -> std::string;
+} // namespace DatabaseQueries
@@ -9,13 +9,19 @@
 #include <esp_pthread.h>
 #include <Wire.h>
 #include <functional>
+#include <vector>
 
 #include "Configuration.hpp"
 #include "Display.hpp"
 #include "LcdBarGraph.hpp"
+#include "LcdFrameBuffer.hpp"
+#include "LcdGlyphCache.hpp"
 #include "Peripherals.hpp"
 #include "Infos.hpp"
 #include "Utils.hpp"
+#include "Scheduler.hpp"
+#include "Bus.hpp"
+#include "Indicator.hpp"
 
 namespace Display
 {
@@ -41,28 +47,70 @@ namespace Display
         POSITIVE
     };
 
-    static LcdBarGraph bar{&lcd, 5, 6, 7};
-    static std::array<State, 3> states{};
-    static std::chrono::system_clock::time_point ignoreTimer{};
+    // Everything is drawn into frame, only the cells that changed reach lcd
+    static LcdFrameBuffer frame{};
+    static LcdGlyphCache glyphs{&frame};
+    static LcdBarGraph bar{&frame, &glyphs};
+    static constexpr uint8_t rows{4};
+    static constexpr uint8_t pageUpdates{6};
+
+    static std::vector<State> states{};
+    // Alarm timers run on the monotonic clock, NTP or a date typed in the configuration must not shorten them
+    static std::chrono::steady_clock::time_point ignoreTimer{};
+    static std::chrono::steady_clock::time_point buzzerTimer{};
+    // An alarm left unacknowledged this long switches the buzzer to bursts
+    static constexpr std::chrono::minutes escalation{5};
+    static size_t pageFirst{};
+    static uint8_t pageAge{};
+
+    // One low priority bus transaction per row, so sensor reads slot in between rows of a redraw
+    static auto drawRow( uint8_t nRow, std::string text, double percentage ) -> void
+    {
+        Bus::submit( Bus::Device::Lcd, Bus::Priority::Low, [nRow, text, percentage]()
+        {
+            frame.setCursor( 0, nRow );
+            frame.print( text.data() );
+            if ( text.size() < 20 )
+            {
+                bar.draw( nRow, text.size(), nRow, 20 - text.size(), percentage );
+            }
+            frame.flush( &lcd, nRow );
+            return true;
+        } );
+    }
 
     static auto update() -> void
     {
+        const auto snapshot{Infos::Snapshot::get()};
+
         size_t nameMaxLength{0};
+        size_t enabledCount{0};
         for ( size_t n{0}; n < states.size(); ++n )
         {
             if ( cfg.sensors[n].enabled )
             {
                 nameMaxLength = std::max( nameMaxLength, cfg.sensors[n].name.length() );
+                enabledCount++;
             }
         }
 
+        // With more enabled sensors than rows the screen pages through them
+        if ( enabledCount <= rows )
+        {
+            pageFirst = 0;
+        }
+        else if ( ++pageAge >= pageUpdates )
+        {
+            pageAge = 0;
+            pageFirst = pageFirst + rows < enabledCount ? pageFirst + rows : 0;
+        }
+
         uint8_t nRow{0};
-        for ( size_t n{0}; n < states.size(); ++n )
+        size_t nEnabled{0};
+        for ( size_t n{0}; n < states.size() and nRow < rows; ++n )
         {
-            if ( cfg.sensors[n].enabled )
+            if ( cfg.sensors[n].enabled and nEnabled++ >= pageFirst )
             {
-                lcd.setCursor( 0, nRow );
-
                 if ( not states[n].blinkHidden )
                 {
                     if ( states[n].warningMode )
@@ -75,36 +123,94 @@ namespace Display
                     states[n].blinkHidden = false;
                 }
 
-                if ( states[n].blinkHidden )
-                {
-                    lcd.print( std::string( nameMaxLength + 1, ' ' ).data() );
-                }
-                else
+                auto text{std::string( nameMaxLength + 1, ' ' )};
+                if ( not states[n].blinkHidden )
                 {
-                    lcd.print( cfg.sensors[n].name.data() );
-                    lcd.print( std::string( nameMaxLength - cfg.sensors[n].name.size() + 1, ' ' ).data() );
+                    text.replace( 0, cfg.sensors[n].name.size(), cfg.sensors[n].name );
                 }
 
-                const auto percentage{ map( Infos::getSensor( n ), cfg.sensors[n].min, cfg.sensors[n].max, 0.0, 100.0 ) };
-                bar.draw( n, nameMaxLength + 1, nRow, 20 - ( nameMaxLength + 1 ), percentage );
+                const auto percentage{ map( snapshot.getSensor( n ), cfg.sensors[n].min, cfg.sensors[n].max, 0.0, 100.0 ) };
+                drawRow( nRow, text, percentage );
                 nRow++;
             }
         }
-        while( nRow < 4 )
+        while( nRow < rows )
         {
-            lcd.setCursor( 0, nRow );
-            lcd.print( std::string( 20, ' ' ).data() );
+            drawRow( nRow, std::string( 20, ' ' ), 0.0 );
             nRow++;
         }
     }
 
+    // Maps the alarm states onto indicator patterns, the hardware keeps playing them even if the loop stalls
+    static auto warning() -> void
+    {
+        auto warningLed{false};
+        auto warningBuzzer{false};
+
+        for ( uint8_t n{0}; n < states.size(); n++ )
+        {
+            if ( cfg.sensors[n].enabled and cfg.sensors[n].alarm.enabled )
+            {
+                if( states[n].warningLed )
+                {
+                    warningLed = true;
+                }
+                if( states[n].warningBuzzer )
+                {
+                    warningBuzzer = true;
+                }
+            }
+        }
+
+        Indicator::set( Indicator::Output::Led, warningLed ? Indicator::Pattern::Blink : Indicator::Pattern::Off );
+
+        const auto now{std::chrono::steady_clock::now()};
+        if ( not warningBuzzer )
+        {
+            buzzerTimer = now;
+            Indicator::set( Indicator::Output::Buzzer, Indicator::Pattern::Off );
+        }
+        else if ( now - buzzerTimer < escalation )
+        {
+            Indicator::set( Indicator::Output::Buzzer, Indicator::Pattern::Beep );
+        }
+        else
+        {
+            Indicator::set( Indicator::Output::Buzzer, Indicator::Pattern::Bursts );
+        }
+    }
+
+    // Names, ranges and alarm levels are read from cfg on every pass, only the alarm states of changed sensors are dropped
+    static auto reconfigure( const Configuration& previous ) -> bool
+    {
+        for ( size_t n{0}; n < std::min( states.size(), std::min( cfg.sensors.size(), previous.sensors.size() ) ); ++n )
+        {
+            const auto& sensor{cfg.sensors[n]};
+            const auto& before{previous.sensors[n]};
+            if ( sensor.enabled != before.enabled or sensor.alarm.enabled != before.alarm.enabled or sensor.alarm.value != before.alarm.value )
+            {
+                states[n] = State{};
+            }
+        }
+        pageFirst = 0;
+        pageAge = 0;
+
+        warning();
+        return true;
+    }
+
     static auto check() -> void
     {
+        const auto snapshot{Infos::Snapshot::get()};
+
+        // The configuration is loaded after init(), so the states follow it here
+        states.resize( cfg.sensors.size() );
+
         for ( uint8_t n = 0; n < states.size(); n++ )
         {
             if ( cfg.sensors[n].enabled and cfg.sensors[n].alarm.enabled )
             {
-                const auto percentage{ map( Infos::getSensor( n ), cfg.sensors[n].min, cfg.sensors[n].max, 0.0, 100.0 ) };
+                const auto percentage{ map( snapshot.getSensor( n ), cfg.sensors[n].min, cfg.sensors[n].max, 0.0, 100.0 ) };
                 const auto bottom{ cfg.sensors[n].alarm.value };
                 const auto top{ min( cfg.sensors[n].alarm.value * 1.05, 100.0 ) };
 
@@ -113,7 +219,7 @@ namespace Display
                     if ( not states[n].warningMode )
                     {
                         states[n].warningLed = true;
-                        if( std::chrono::system_clock::now() >= ignoreTimer )
+                        if( std::chrono::steady_clock::now() >= ignoreTimer )
                         {
                             states[n].warningBuzzer = true;
                         }
@@ -128,74 +234,39 @@ namespace Display
                 }
             }
         }
+
+        warning();
     }
 
     auto ignore() -> void
     {
-        digitalWrite( Peripherals::Pins::WRN_BZR, LOW );
-
         for ( uint8_t n = 0; n < states.size(); n++ )
         {
             states[n].warningBuzzer = false;
         }
-        ignoreTimer = std::chrono::system_clock::now() + std::chrono::minutes( 10 );
-    }
-
-    static auto warning() -> void
-    {
-        auto warningLed{false};
-        auto warningBuzzer{false};
-
-        for ( uint8_t n{0}; n < states.size(); n++ )
-        {
-            if ( cfg.sensors[n].enabled and cfg.sensors[n].alarm.enabled )
-            {
-                if( states[n].warningLed )
-                {
-                    warningLed = true;
-                }
-                if( states[n].warningBuzzer )
-                {
-                    warningBuzzer = true;
-                }
-            }
-        }
-
-        if ( warningLed )
-        {
-            digitalWrite( Peripherals::Pins::LED_HTB, not digitalRead( Peripherals::Pins::LED_HTB ) );
-        }
-        else
-        {
-            digitalWrite( Peripherals::Pins::LED_HTB, LOW );
-        }
+        ignoreTimer = std::chrono::steady_clock::now() + std::chrono::minutes( 10 );
 
-        if ( warningBuzzer )
-        {
-            digitalWrite( Peripherals::Pins::WRN_BZR, not digitalRead( Peripherals::Pins::WRN_BZR ) );
-        }
-        else
-        {
-            digitalWrite( Peripherals::Pins::WRN_BZR, LOW );
-        }
+        warning();
     }
 
     auto init() -> void
     {
-        lcd.begin( 20, 4 );
-        lcd.home();
+        Bus::execute( Bus::Device::Lcd, []()
+        {
+            lcd.begin( 20, 4 );
+            lcd.home();
+            frame.begin( 20, 4 );
 
-        bar.init();
+            bar.init();
 
-        lcd.setCursor( 0, 0 );
-        lcd.print( "Inicializando2..." );
-        delay( 1000 );
-    }
+            frame.setCursor( 0, 0 );
+            frame.print( "Inicializando2..." );
+            frame.flush( &lcd );
+            return true;
+        } );
 
-    auto process() -> void
-    {
-        Utils::periodic( std::chrono::milliseconds( 500 ), Display::update );
-        Utils::periodic( std::chrono::milliseconds( 250 ), Display::check );
-        Utils::periodic( std::chrono::milliseconds( 750 ), Display::warning );
+        Scheduler::periodic( std::chrono::milliseconds( 500 ), Display::update );
+        Scheduler::periodic( std::chrono::milliseconds( 250 ), Display::check );
+        Configuration::onChange( Display::reconfigure );
     }
 } // namespace Display
\ No newline at end of file
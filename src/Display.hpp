@@ -5,6 +5,5 @@
 namespace Display
 {
     auto init() -> void;
-    auto process() -> void;
     auto ignore() -> void;
 }
\ No newline at end of file
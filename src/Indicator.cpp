@@ -0,0 +1,119 @@
+#include <Arduino.h>
+
+#include <array>
+#include <cstdlib>
+#include <driver/rmt.h>
+#include <esp_log.h>
+
+#include "Indicator.hpp"
+#include "Peripherals.hpp"
+
+namespace Indicator
+{
+    struct Step
+    {
+        uint16_t onMs;
+        uint16_t offMs;
+    };
+
+    struct Channel
+    {
+        rmt_channel_t channel;
+        gpio_num_t pin;
+        Pattern pattern;
+    };
+
+    // 1 MHz REF_TICK divided down to 250 us per tick, a single level can then last up to 8 s
+    static constexpr uint8_t clockDivider{250};
+    static constexpr uint32_t ticksPerMs{4};
+    // One RMT memory block holds 64 items, the last one is the end marker
+    static constexpr size_t maxSteps{63};
+
+    // Steady blink for the LED, a short chirp for a fresh alarm, then three quick beeps once it was left unattended
+    static constexpr Step blink[] { {750, 750} };
+    static constexpr Step beep[] { {100, 2900} };
+    static constexpr Step bursts[] { {150, 100}, {150, 100}, {150, 1000} };
+
+    static std::array<Channel, OutputsCount> channels
+    {{
+        {RMT_CHANNEL_0, static_cast<gpio_num_t>( Peripherals::Pins::LED_HTB ), Off},
+        {RMT_CHANNEL_1, static_cast<gpio_num_t>( Peripherals::Pins::WRN_BZR ), Off},
+    }};
+
+    template<size_t N>
+    static auto program( rmt_channel_t channel, const Step ( &steps )[N] ) -> void
+    {
+        static_assert( N <= maxSteps, "pattern does not fit a memory block" );
+
+        auto items{std::array<rmt_item32_t, N + 1> {}};
+        for ( size_t n{0}; n < N; ++n )
+        {
+            items[n].level0 = 1;
+            items[n].duration0 = steps[n].onMs * ticksPerMs;
+            items[n].level1 = 0;
+            items[n].duration1 = steps[n].offMs * ticksPerMs;
+        }
+        // A zero duration ends the sequence, in loop mode the hardware restarts from the first item
+        items[N].val = 0;
+
+        rmt_fill_tx_items( channel, items.data(), items.size(), 0 );
+        rmt_tx_start( channel, true );
+    }
+
+    auto init() -> void
+    {
+        log_d( "begin" );
+
+        for ( const auto& output : channels )
+        {
+            auto config{rmt_config_t{}};
+            config.rmt_mode = RMT_MODE_TX;
+            config.channel = output.channel;
+            config.clk_div = clockDivider;
+            config.gpio_num = output.pin;
+            config.mem_block_num = 1;
+            config.tx_config.loop_en = true;
+            config.tx_config.carrier_en = false;
+            config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+            config.tx_config.idle_output_en = true;
+
+            if ( rmt_config( &config ) != ESP_OK or
+                    rmt_set_source_clk( output.channel, RMT_BASECLK_REF ) != ESP_OK or
+                    rmt_driver_install( output.channel, 0, 0 ) != ESP_OK )
+            {
+                log_e( "rmt error" );
+                std::abort();
+            }
+        }
+
+        log_d( "end" );
+    }
+
+    auto set( Output output, Pattern pattern ) -> void
+    {
+        auto& current{channels[output]};
+        if ( current.pattern == pattern )
+        {
+            return;
+        }
+        current.pattern = pattern;
+
+        rmt_tx_stop( current.channel );
+        switch ( pattern )
+        {
+            case Blink:
+                program( current.channel, blink );
+                break;
+            case Beep:
+                program( current.channel, beep );
+                break;
+            case Bursts:
+                program( current.channel, bursts );
+                break;
+            case Off:
+                // The stop cuts the pattern wherever it is, possibly with the output high, the idle level brings it back low
+                rmt_set_idle_level( current.channel, true, RMT_IDLE_LEVEL_LOW );
+                break;
+        }
+    }
+} // namespace Indicator
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace Indicator
+{
+    enum Output
+    {
+        Led,
+        Buzzer,
+        OutputsCount
+    };
+
+    enum Pattern
+    {
+        Off,
+        Blink,
+        Beep,
+        Bursts
+    };
+
+    auto init() -> void;
+    // Reprograms the output only when the pattern changes, the RMT peripheral then repeats it on its own
+    auto set( Output output, Pattern pattern ) -> void;
+} // namespace Indicator
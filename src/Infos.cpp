@@ -1,6 +1,5 @@
 #include <Arduino.h>
 
-#include <ResponsiveAnalogRead.h>
 #include <array>
 #include <chrono>
 #include <future>
@@ -9,122 +8,263 @@
 #include <BME280I2C.h>
 #include <map>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <SeqLock.hpp>
 
 #include "Configuration.hpp"
 #include "Display.hpp"
 #include "Peripherals.hpp"
 #include "Infos.hpp"
 #include "Utils.hpp"
+#include "Scheduler.hpp"
+#include "Sampling.hpp"
+#include "SensorModels.hpp"
+#include "SensorKernels.hpp"
+#include "SensorDrivers.hpp"
+#include "Bus.hpp"
+#include "Boot.hpp"
 
 namespace Infos
 {
+    // Sensor readings are kept in centi-kPa, doubles only appear when they leave the module
     struct Info
     {
-        uint8_t pin;
-        double value;
-        ResponsiveAnalogRead analogRead;
+        std::unique_ptr<SensorDrivers::Driver> driver;
+        int32_t( *kernel )( const SensorKernels::Map& map, uint32_t counts );
+        SensorKernels::Map map;
+        SensorKernels::Ema ema;
+        uint16_t ticks;
+        uint16_t countdown;
+        int32_t value;
+    };
+
+    static constexpr auto tick{std::chrono::milliseconds( 1000 / Sampling::outputRate )};
+    static constexpr auto updatePeriod{std::chrono::milliseconds( 600000 )};
+
+    struct Environment
+    {
+        float temperature;
+        float humidity;
+        float pressure;
     };
 
     static BME280I2C bme{};
-    static std::array<Info, 3> infos
+    // Written by the bus task, read back on the loop task by publish()
+    static Environment environment{NAN, NAN, NAN};
+    static std::vector<Info> infos{};
+    static SeqLock<Snapshot> snapshots{};
+    static void( *updateCallback )() {};
+
+    template<typename Model>
+    static auto calibrate( Info* info, const Configuration::Sensor::Calibration& calibration ) -> void
+    {
+        info->kernel = SensorKernels::convert<Model>;
+        info->map = SensorKernels::calibrate<Model>( calibration.angularCoefficient, calibration.linearCoefficient, Sampling::oversamplingBits );
+    }
+
+    // Indexed by Configuration::Sensor::Type
+    static constexpr std::array<void( * )( Info*, const Configuration::Sensor::Calibration& ), 4> models
     {
+        calibrate<SensorModels::MPX5050>,
+        calibrate<SensorModels::MPX5100>,
+        calibrate<SensorModels::MPX5500>,
+        calibrate<SensorModels::MPX5700>
+    };
+
+    static auto prepare() -> void
+    {
+        infos = std::vector<Info>( cfg.sensors.size() );
+        for ( auto n{0}; n < infos.size(); ++n )
         {
-            {Peripherals::MPX_DP::VOUT_1},
-            {Peripherals::MPX_DP::VOUT_2},
-            {Peripherals::MPX_DP::VOUT_3}
+            auto& info{infos[n]};
+            models[cfg.sensors[n].type]( &info, cfg.sensors[n].calibration );
+            info.driver = SensorDrivers::create( cfg.sensors[n] );
+            if ( info.driver != nullptr )
+            {
+                // The EMA spans the samples this driver delivers per update period
+                const auto interval{std::max( info.driver->interval(), tick )};
+                info.ticks = interval / tick;
+                info.ema.factor = SensorKernels::weight( updatePeriod / interval );
+            }
+            info.countdown = 0;
+            info.ema.seeded = false;
         }
-    };
-    static float pressure{NAN};
-    static float temperature{NAN};
-    static float humidity{NAN};
+    }
 
-    static auto read( uint8_t index ) -> double
+    static auto filter( Info* info, uint32_t counts ) -> void
     {
-        static constexpr std::array<double, 4> sensorsMax{50.0, 100.0, 500.0, 700.0};
-        static constexpr std::array<double, 4> sensorsSensivity{0.0900, 0.0450, 0.0090, 0.0064};
-        static constexpr double sensorsZeroOffset{-0.2000};
+        info->value = SensorKernels::filter( &info->ema, info->kernel( info->map, counts ) );
+    }
 
-        infos[index].analogRead.update();
-        const auto rawRead{infos[index].analogRead.getValue()};
-        const auto calibratedRead{ rawRead* cfg.sensors[index].calibration.angularCoefficient + cfg.sensors[index].calibration.linearCoefficient };
-        const auto sensorValue{ ( calibratedRead + sensorsZeroOffset ) / sensorsSensivity[cfg.sensors[index].type] };
-        return constrain( sensorValue, 0.0, sensorsMax[cfg.sensors[index].type] );
+    // One pass over the registry per tick, each sensor is read only when its driver interval comes around
+    static auto sample() -> void
+    {
+        for ( auto n{0}; n < infos.size(); ++n )
+        {
+            auto& info{infos[n]};
+            if ( not cfg.sensors[n].enabled or info.driver == nullptr )
+            {
+                continue;
+            }
+            if ( info.countdown > 0 )
+            {
+                info.countdown--;
+                continue;
+            }
+            info.countdown = info.ticks - 1;
+            filter( &info, info.driver->read() );
+        }
     }
 
-    static auto update() -> void
+    static auto publish( bool ) -> void
+    {
+        auto snapshot{Snapshot{environment.temperature, environment.humidity, environment.pressure}};
+        snapshot.count = infos.size();
+        for ( auto n{0}; n < infos.size(); ++n )
+        {
+            snapshot.sensors[n] = infos[n].value;
+        }
+        snapshots.store( snapshot );
+        Boot::reading();
+
+        if ( updateCallback != nullptr )
+        {
+            updateCallback();
+        }
+    }
+
+    // Calibrations follow in place, the filter restarts from the next sample
+    static auto reconfigure( const Configuration& previous ) -> bool
     {
-        bme.read( pressure, temperature, humidity, BME280::TempUnit_Celsius, BME280::PresUnit_hPa );
+        if ( cfg.sensors.size() != previous.sensors.size() )
+        {
+            return false;
+        }
         for ( auto n{0}; n < infos.size(); ++n )
         {
-            if( cfg.sensors[n].enabled )
+            const auto& sensor{cfg.sensors[n]};
+            const auto& before{previous.sensors[n]};
+            // An Ads1115 driver may still have a bus transaction holding it, so drivers are only replaced by a restart
+            if ( sensor.driver != before.driver or sensor.address != before.address or sensor.channel != before.channel )
+            {
+                return false;
+            }
+            if ( sensor.type != before.type or sensor.calibration.angularCoefficient != before.calibration.angularCoefficient or sensor.calibration.linearCoefficient != before.calibration.linearCoefficient )
             {
-                static constexpr uint32_t updatePeriod{ 600000 };
-                static constexpr uint32_t sampleInterval{ 500 };
-                static constexpr double factor{ 2.0 / ( updatePeriod / sampleInterval + 1.0 ) };
-                infos[n].value = ( factor * read( n ) ) + ( ( 1.0 - factor ) * infos[n].value );
+                log_d( "recalibrate = %s", sensor.name.data() );
+                models[sensor.type]( &infos[n], sensor.calibration );
+                infos[n].ema.seeded = false;
             }
         }
+        return true;
+    }
+
+    static auto update() -> void
+    {
+        Bus::submit( Bus::Device::Bme280, Bus::Priority::High, []()
+        {
+            bme.read( environment.pressure, environment.temperature, environment.humidity, BME280::TempUnit_Celsius, BME280::PresUnit_hPa );
+            return not std::isnan( environment.temperature );
+        }, Infos::publish );
     }
 
-    auto getSensor( uint8_t index ) -> double
+    auto Snapshot::get() -> Snapshot
     {
-        return ( round( infos[index].value * 100 ) / 100 );
+        return snapshots.load();
     }
 
-    auto getPressure() -> double
+    auto Snapshot::getSensor( uint8_t index ) const -> double
     {
-        return ( round( pressure * 100 ) / 100 );
+        return this->sensors[index] / 100.0;
     }
 
-    auto getTemperature() -> double
+    auto Snapshot::getPressure() const -> double
     {
-        return ( round( temperature * 100 ) / 100 );
+        return ( round( this->pressure * 100 ) / 100 );
     }
 
-    auto getHumidity() -> double
+    auto Snapshot::getTemperature() const -> double
     {
-        return ( round( humidity * 100 ) / 100 );
+        return ( round( this->temperature * 100 ) / 100 );
+    }
+
+    auto Snapshot::getHumidity() const -> double
+    {
+        return ( round( this->humidity * 100 ) / 100 );
     }
 
     auto init() -> void
     {
-        if( not bme.begin() )
+        const auto found{Bus::execute( Bus::Device::Bme280, []()
+        {
+            return bme.begin();
+        } )};
+        if( not found )
         {
             log_d( "bme error" );
         }
 
-        for ( auto n{0}; n < infos.size(); ++n )
+        prepare();
+        snapshots.store( Snapshot{NAN, NAN, NAN} );
+
+        const auto internal{std::any_of( cfg.sensors.begin(), cfg.sensors.end(), []( const Configuration::Sensor & sensor )
         {
-            if( cfg.sensors[n].enabled )
-            {
-                infos[n].analogRead.begin( infos[n].pin, false );
-                infos[n].analogRead.setAnalogResolution( 4096 );
-                infos[n].value = read( n );
-            }
+            return sensor.driver == Configuration::Sensor::Driver::Internal;
+        } )};
+        if ( internal )
+        {
+            Sampling::init();
+        }
+
+        Scheduler::periodic( tick, Infos::sample );
+        Scheduler::periodic( std::chrono::milliseconds( 500 ), Infos::update );
+        Configuration::onChange( Infos::reconfigure );
+    }
+
+    auto onUpdate( void( *callback )() ) -> void
+    {
+        updateCallback = callback;
+    }
+
+    auto convert( uint8_t index, uint32_t counts ) -> double
+    {
+        if ( index >= infos.size() or infos[index].driver == nullptr )
+        {
+            return NAN;
         }
+        return infos[index].kernel( infos[index].map, counts ) / 100.0;
     }
 
-    auto process() -> void
+    auto invert( uint8_t index, double value ) -> uint32_t
     {
-        Utils::periodic( std::chrono::milliseconds( 500 ), Infos::update );
+        if ( index >= infos.size() )
+        {
+            return 0;
+        }
+        return SensorKernels::invert( infos[index].map, static_cast<int32_t>( llround( value * 100 ) ) );
     }
 
-    auto serialize( ArduinoJson::JsonVariant& json ) -> void
+    auto Snapshot::serialize( ArduinoJson::JsonVariant& json ) const -> void
     {
-        json["temperature"] = Infos::getTemperature();
-        json["humidity"] = Infos::getHumidity();
-        json["pressure"] = Infos::getPressure();
+        json["temperature"] = this->getTemperature();
+        json["humidity"] = this->getHumidity();
+        json["pressure"] = this->getPressure();
         {
+            // Also called from the AsyncTCP task, which must not read cfg while the loop replaces it
+            const auto config{Configuration::get()};
             auto sensors{ json["sensors"] };
-            for ( auto n{0}; n < Infos::infos.size(); ++n )
+            for ( size_t n{0}; n < std::min( size_t{this->count}, config.sensors.size() ); ++n )
             {
-                if( cfg.sensors[n].enabled )
+                if( config.sensors[n].enabled )
                 {
                     auto sensor{ sensors.addElement() };
 
-                    sensor["name"] = cfg.sensors[n].name;
-                    sensor["value"] = Infos::getSensor( n );
-                    sensor["percent"] = map( Infos::getSensor( n ), cfg.sensors[n].min, cfg.sensors[n].max, 0.0, 100.0 );
+                    sensor["name"] = config.sensors[n].name;
+                    sensor["value"] = this->getSensor( n );
+                    sensor["percent"] = map( this->getSensor( n ), config.sensors[n].min, config.sensors[n].max, 0.0, 100.0 );
                 }
             }
         }
@@ -3,15 +3,33 @@
 #include <Arduino.h>
 
 #include <ArduinoJson.hpp>
+#include <array>
+
+#include "Configuration.hpp"
 
 namespace Infos
 {
-    auto init() -> void;
-    auto process() -> void;
-    auto getSensor( uint8_t index ) -> double;
-    auto getPressure() -> double;
-    auto getTemperature() -> double;
-    auto getHumidity() -> double;
+    // Consistent set of readings, published once per update
+    struct Snapshot
+    {
+        float temperature;
+        float humidity;
+        float pressure;
+        std::array<int32_t, Configuration::maxSensors> sensors;
+        uint8_t count;
 
-    auto serialize( ArduinoJson::JsonVariant& json ) -> void;
+        static auto get() -> Snapshot;
+        auto getSensor( uint8_t index ) const -> double;
+        auto getPressure() const -> double;
+        auto getTemperature() const -> double;
+        auto getHumidity() const -> double;
+        auto serialize( ArduinoJson::JsonVariant& json ) const -> void;
+    };
+
+    auto init() -> void;
+    auto onUpdate( void( *callback )() ) -> void;
+    // Raw driver counts of sensor index in kPa, converted like live readings but unfiltered
+    auto convert( uint8_t index, uint32_t counts ) -> double;
+    // The driver counts sensor index reads at value kPa, the inverse of convert()
+    auto invert( uint8_t index, double value ) -> uint32_t;
 }
\ No newline at end of file
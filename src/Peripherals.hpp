@@ -64,6 +64,18 @@ namespace Peripherals
         static constexpr uint8_t I2C_ADDRESS{0x68};
     }; // namespace DS3231
 
+    namespace ADS1115
+    {
+        enum Pins
+        {
+            SDA = 21,
+            SCL = 22
+        };
+        // ADDR strapped to GND, VDD, SDA, SCL gives 0x48 to 0x4B
+        static constexpr uint8_t I2C_ADDRESS{0x48};
+        static constexpr uint8_t CHANNELS{4};
+    }; // namespace ADS1115
+
     namespace MPX_DP
     {
         enum Pins
@@ -72,6 +84,14 @@ namespace Peripherals
             VOUT_2 = 32,
             VOUT_3 = 35
         };
+
+        // ADC1 channels wired to the VOUT pins
+        enum Channels
+        {
+            CHANNEL_1 = 5,
+            CHANNEL_2 = 4,
+            CHANNEL_3 = 7
+        };
     };
 
     enum Pins
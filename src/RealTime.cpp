@@ -22,15 +22,30 @@
 #include "Peripherals.hpp"
 #include "RealTime.hpp"
 #include "Utils.hpp"
+#include "Scheduler.hpp"
+#include "Bus.hpp"
+#include "SleepLog.hpp"
 
 namespace RealTime
 {
     static RtcDS3231<TwoWire> rtc{Wire};
+    static DS3231AlarmFlag alarmFlags{};
 
-    static auto syncDateTime() -> void
+    // rtc is only used from bus transactions
+    static auto readDateTime() -> bool
     {
         const auto time{timeval{static_cast<std::time_t>( rtc.GetDateTime().Epoch32Time() )}};
+        if ( rtc.LastError() != I2C_ERROR_OK )
+        {
+            return false;
+        }
         settimeofday( &time, nullptr );
+        return true;
+    }
+
+    static auto syncDateTime() -> void
+    {
+        Bus::submit( Bus::Device::Ds3231, Bus::Priority::Normal, RealTime::readDateTime );
     }
 
     static auto startHardware() -> void
@@ -86,17 +101,46 @@ namespace RealTime
     {
         if ( cfg.autoSleepWakeUp.enabled )
         {
-            const auto flags{rtc.LatchAlarmsTriggeredFlags()};
-            if ( flags & DS3231AlarmFlag_Alarm2 )
+            Bus::submit( Bus::Device::Ds3231, Bus::Priority::Normal, []()
             {
-                sleep();
-            }
+                alarmFlags = rtc.LatchAlarmsTriggeredFlags();
+                return rtc.LastError() == I2C_ERROR_OK;
+            }, []( bool ok )
+            {
+                if ( ok and alarmFlags & DS3231AlarmFlag_Alarm2 )
+                {
+                    sleep();
+                }
+            } );
+        }
+    }
+
+    // Only the alarms depend on the configuration, the log interval is read when going to sleep
+    static auto reconfigure( const Configuration& previous ) -> bool
+    {
+        const auto& before{previous.autoSleepWakeUp};
+        const auto& after{cfg.autoSleepWakeUp};
+        if ( after.enabled == before.enabled and after.sleepTime == before.sleepTime and after.wakeUpTime == before.wakeUpTime )
+        {
+            return true;
         }
+
+        return Bus::execute( Bus::Device::Ds3231, []()
+        {
+            configureAlarms();
+            return rtc.LastError() == I2C_ERROR_OK;
+        } );
     }
 
     auto sleep() -> void
     {
-        rtc.SetSquareWavePin( DS3231SquareWavePin_ModeAlarmOne );
+        Database::flush();
+        Bus::execute( Bus::Device::Ds3231, []()
+        {
+            rtc.SetSquareWavePin( DS3231SquareWavePin_ModeAlarmOne );
+            return rtc.LastError() == I2C_ERROR_OK;
+        } );
+        SleepLog::arm();
         esp_deep_sleep_start();
     }
 
@@ -104,12 +148,19 @@ namespace RealTime
     {
         log_d( "begin" );
 
-        startHardware();
-        configureAlarms();
-        syncDateTime();
+        Bus::execute( Bus::Device::Ds3231, []()
+        {
+            startHardware();
+            configureAlarms();
+            return readDateTime();
+        } );
 
         log_d( "now = %s", Utils::DateTime::toString( std::chrono::system_clock::now() ).data() );
 
+        Scheduler::periodic( std::chrono::minutes( 5 ), RealTime::syncDateTime );
+        Scheduler::periodic( std::chrono::minutes( 1 ), RealTime::checkSleep );
+        Configuration::onChange( RealTime::reconfigure );
+
         log_d( "end" );
     }
 
@@ -117,13 +168,12 @@ namespace RealTime
     {
         RtcDateTime rtcDateTime{};
         rtcDateTime.InitWithEpoch32Time( std::chrono::system_clock::to_time_t( timePoint ) );
-        rtc.SetDateTime( rtcDateTime );
-        rtc.SetIsRunning( true );
-    }
-
-    auto process() -> void
-    {
-        Utils::periodic( std::chrono::minutes( 5 ), RealTime::syncDateTime );
-        Utils::periodic( std::chrono::minutes( 1 ), RealTime::checkSleep );
+        Bus::execute( Bus::Device::Ds3231, [&rtcDateTime]()
+        {
+            rtc.SetDateTime( rtcDateTime );
+            rtc.SetIsRunning( true );
+            // The system clock follows right away instead of at the next sync
+            return rtc.LastError() == I2C_ERROR_OK and readDateTime();
+        } );
     }
 } // namespace RealTime
\ No newline at end of file
@@ -10,7 +10,6 @@
 namespace RealTime
 {
     auto init() -> void;
-    auto process() -> void;
     auto adjustDateTime( const std::chrono::system_clock::time_point& timePoint ) -> void;
     auto sleep() -> void;
 } // namespace RealTime
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include <Arduino.h>
+
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#include <soc/syscon_struct.h>
+#include <esp_log.h>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+
+#include "Peripherals.hpp"
+#include "Sampling.hpp"
+
+namespace Sampling
+{
+    static constexpr auto port{I2S_NUM_0};
+    static constexpr uint32_t sampleRate{6000};
+    static constexpr size_t dmaBufferCount{4};
+    static constexpr size_t dmaBufferLength{256};
+
+    // Order of the conversions in the SAR1 pattern table, one entry per sensor
+    static constexpr std::array<adc1_channel_t, channelsCount> channels
+    {
+        static_cast<adc1_channel_t>( Peripherals::MPX_DP::CHANNEL_1 ),
+        static_cast<adc1_channel_t>( Peripherals::MPX_DP::CHANNEL_2 ),
+        static_cast<adc1_channel_t>( Peripherals::MPX_DP::CHANNEL_3 )
+    };
+    static constexpr uint32_t decimation{sampleRate / channels.size() / outputRate};
+
+    struct Accumulator
+    {
+        uint32_t sum;
+        uint32_t count;
+    };
+
+    static TaskHandle_t samplingTask{};
+    static std::array<std::atomic<uint32_t>, channelsCount> published{};
+    static std::array<std::atomic<uint32_t>, channelsCount> converted{};
+
+    static auto configurePattern() -> void
+    {
+        // Pattern entry: channel in bits 4..7, width in bits 2..3 (3 = 12 bit), attenuation in bits 0..1
+        auto table{uint32_t{}};
+        for ( size_t n{0}; n < channels.size(); ++n )
+        {
+            const auto entry{static_cast<uint32_t>( ( channels[n] << 4 ) | ( ADC_WIDTH_BIT_12 << 2 ) | ADC_ATTEN_DB_11 )};
+            table |= entry << ( 24 - 8 * n );
+        }
+        SYSCON.saradc_ctrl.sar1_patt_len = channels.size() - 1;
+        SYSCON.saradc_sar1_patt_tab[0] = table;
+    }
+
+    static auto startConversion() -> void
+    {
+        const auto config{i2s_config_t
+        {
+            static_cast<i2s_mode_t>( I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN ),
+            sampleRate,
+            I2S_BITS_PER_SAMPLE_16BIT,
+            I2S_CHANNEL_FMT_ONLY_LEFT,
+            I2S_COMM_FORMAT_I2S_MSB,
+            0,
+            dmaBufferCount,
+            dmaBufferLength,
+            false
+        }};
+
+        if ( i2s_driver_install( port, &config, 0, nullptr ) != ESP_OK )
+        {
+            log_e( "i2s install error" );
+            std::abort();
+        }
+
+        adc1_config_width( ADC_WIDTH_BIT_12 );
+        for ( const auto channel : channels )
+        {
+            adc1_config_channel_atten( channel, ADC_ATTEN_DB_11 );
+        }
+        i2s_set_adc_mode( ADC_UNIT_1, channels[0] );
+
+        if ( i2s_adc_enable( port ) != ESP_OK )
+        {
+            log_e( "i2s adc error" );
+            std::abort();
+        }
+        // i2s_adc_enable() resets the SAR1 pattern to the single channel of i2s_set_adc_mode(), so it goes in afterwards
+        configurePattern();
+    }
+
+    static auto sample( void* ) -> void
+    {
+        log_d( "begin" );
+
+        static std::array<uint16_t, dmaBufferLength> buffer{};
+        auto accumulators{std::array<Accumulator, channelsCount> {}};
+
+        while ( true )
+        {
+            auto bytesRead{size_t{}};
+            if ( i2s_read( port, buffer.data(), sizeof( buffer ), &bytesRead, portMAX_DELAY ) != ESP_OK )
+            {
+                continue;
+            }
+
+            for ( size_t n{0}; n < bytesRead / sizeof( uint16_t ); ++n )
+            {
+                // Each DMA word tags its 12 bit value with the ADC channel in the top nibble
+                const auto channel{buffer[n] >> 12};
+                const auto value{buffer[n] & 0x0FFF};
+                for ( size_t index{0}; index < channels.size(); ++index )
+                {
+                    if ( channels[index] == channel )
+                    {
+                        accumulators[index].sum += value;
+                        accumulators[index].count++;
+                    }
+                }
+            }
+
+            // Counted over every channel, a channel missing from the DMA frames must not stall the others
+            auto total{uint32_t{}};
+            for ( const auto& accumulator : accumulators )
+            {
+                total += accumulator.count;
+            }
+            if ( total < decimation * channels.size() )
+            {
+                continue;
+            }
+
+            // Boxcar oversampling: the mean of the block gains resolution below one ADC count
+            for ( size_t index{0}; index < channels.size(); ++index )
+            {
+                const auto& accumulator{accumulators[index]};
+                converted[index].fetch_add( accumulator.count, std::memory_order_relaxed );
+                if ( accumulator.count == 0 )
+                {
+                    // Keeps the last value rather than publishing 0 for a channel the pattern table lost
+                    log_e( "channel %u got no conversions", static_cast<unsigned>( index ) );
+                    continue;
+                }
+                published[index].store( ( accumulator.sum << oversamplingBits ) / accumulator.count, std::memory_order_relaxed );
+            }
+            accumulators = std::array<Accumulator, channelsCount> {};
+        }
+    }
+
+    auto init() -> void
+    {
+        log_d( "begin" );
+
+        startConversion();
+        xTaskCreatePinnedToCore( Sampling::sample, "sampling", 4096, nullptr, 2, &samplingTask, 0 );
+
+        log_d( "end" );
+    }
+
+    auto get( uint8_t index ) -> uint32_t
+    {
+        return published[index].load( std::memory_order_relaxed );
+    }
+
+    auto conversions( uint8_t index ) -> uint32_t
+    {
+        return converted[index].load( std::memory_order_relaxed );
+    }
+
+    auto read( uint8_t index ) -> uint32_t
+    {
+        adc1_config_width( ADC_WIDTH_BIT_12 );
+        adc1_config_channel_atten( channels[index], ADC_ATTEN_DB_11 );
+
+        // The sum of 2^oversamplingBits conversions is their mean with oversamplingBits fractional bits
+        auto sum{uint32_t{}};
+        for ( uint32_t n{0}; n < ( 1u << oversamplingBits ); ++n )
+        {
+            sum += adc1_get_raw( channels[index] );
+        }
+        return sum;
+    }
+
+    auto channel( uint8_t index ) -> adc1_channel_t
+    {
+        return channels[index];
+    }
+} // namespace Sampling
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+#include <array>
+#include <driver/adc.h>
+
+namespace Sampling
+{
+    // Decimated values carry this many extra fractional bits over the 12 bit ADC
+    static constexpr uint8_t oversamplingBits{4};
+    static constexpr uint16_t outputRate{10};
+    static constexpr uint8_t channelsCount{3};
+
+    auto init() -> void;
+    auto get( uint8_t index ) -> uint32_t;
+    // Conversions the DMA frames delivered for this channel since init(), stays 0 for a channel missing from the pattern
+    auto conversions( uint8_t index ) -> uint32_t;
+    // One blocking oversampled conversion in the same units as get(), for when the sampler is not running
+    auto read( uint8_t index ) -> uint32_t;
+    auto channel( uint8_t index ) -> adc1_channel_t;
+} // namespace Sampling
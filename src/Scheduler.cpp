@@ -0,0 +1,152 @@
+#include <Arduino.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#include "Scheduler.hpp"
+#include "Utils.hpp"
+
+namespace Scheduler
+{
+    struct Task
+    {
+        void( *func )();
+        std::chrono::microseconds interval;
+        std::chrono::microseconds deadline;
+        bool bound;
+    };
+
+    // Free slots have no func, the table leaves room for tasks added after the boot
+    static std::array<Task, 16> tasks{};
+    static std::array<uint8_t, 16> heap{};
+    static size_t count{};
+    // The task process() is running is out of the heap until it is rescheduled
+    static size_t running{tasks.size()};
+    static bool runningCancelled{false};
+
+    // esp_timer is monotonic, settimeofday() does not move deadlines
+    static auto now() -> std::chrono::microseconds
+    {
+        return std::chrono::microseconds( esp_timer_get_time() );
+    }
+
+    static auto later( size_t a, size_t b ) -> bool
+    {
+        return tasks[a].deadline > tasks[b].deadline;
+    }
+
+    static auto schedule( Task* task, std::chrono::microseconds current ) -> void
+    {
+        if ( task->bound )
+        {
+            // Realigned on the wall clock each time, a clock jump delays or advances a single run
+            const auto wallClock{std::chrono::system_clock::now()};
+            const auto next{Utils::DateTime::ceil( wallClock + std::chrono::milliseconds( 1 ), std::chrono::duration_cast<std::chrono::milliseconds>( task->interval ) )};
+            task->deadline = current + std::chrono::duration_cast<std::chrono::microseconds>( next - wallClock );
+        }
+        else
+        {
+            task->deadline += task->interval;
+            if ( task->deadline <= current )
+            {
+                // Overrun, skip the missed runs instead of bursting
+                task->deadline = current + task->interval;
+            }
+        }
+    }
+
+    static auto add( std::chrono::milliseconds interval, void( *func )(), bool bound ) -> void
+    {
+        const auto slot{std::find_if( tasks.begin(), tasks.end(), []( const Task & task )
+        {
+            return task.func == nullptr;
+        } )};
+        if ( slot == tasks.end() )
+        {
+            log_e( "task table full" );
+            std::abort();
+        }
+
+        auto& task{*slot};
+        task = Task{func, interval, now(), bound};
+        if ( bound )
+        {
+            schedule( &task, task.deadline );
+        }
+
+        heap[count] = slot - tasks.begin();
+        count++;
+        std::push_heap( heap.begin(), heap.begin() + count, later );
+    }
+
+    auto periodic( std::chrono::milliseconds interval, void( *func )() ) -> void
+    {
+        add( interval, func, false );
+    }
+
+    auto bound( std::chrono::milliseconds interval, void( *func )() ) -> void
+    {
+        add( interval, func, true );
+    }
+
+    auto cancel( void( *func )() ) -> void
+    {
+        if ( running < tasks.size() and tasks[running].func == func )
+        {
+            runningCancelled = true;
+            return;
+        }
+
+        const auto position{std::find_if( heap.begin(), heap.begin() + count, [func]( uint8_t index )
+        {
+            return tasks[index].func == func;
+        } )};
+        if ( position == heap.begin() + count )
+        {
+            return;
+        }
+
+        tasks[*position].func = nullptr;
+        *position = heap[count - 1];
+        count--;
+        std::make_heap( heap.begin(), heap.begin() + count, later );
+    }
+
+    auto process() -> void
+    {
+        const auto current{now()};
+        while ( count > 0 and tasks[heap[0]].deadline <= current )
+        {
+            std::pop_heap( heap.begin(), heap.begin() + count, later );
+            count--;
+            running = heap[count];
+
+            tasks[running].func();
+            if ( runningCancelled )
+            {
+                tasks[running].func = nullptr;
+                runningCancelled = false;
+            }
+            else
+            {
+                schedule( &tasks[running], now() );
+                heap[count] = running;
+                count++;
+                std::push_heap( heap.begin(), heap.begin() + count, later );
+            }
+            running = tasks.size();
+        }
+    }
+
+    auto untilNext() -> std::chrono::microseconds
+    {
+        if ( count == 0 )
+        {
+            return std::chrono::microseconds::max();
+        }
+        return std::max( tasks[heap[0]].deadline - now(), std::chrono::microseconds::zero() );
+    }
+} // namespace Scheduler
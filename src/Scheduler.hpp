@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+#include <chrono>
+
+namespace Scheduler
+{
+    // Runs func now and then every interval
+    auto periodic( std::chrono::milliseconds interval, void( *func )() ) -> void;
+    // Runs func on every wall clock multiple of interval
+    auto bound( std::chrono::milliseconds interval, void( *func )() ) -> void;
+    // Stops the task running func, func itself may call it to retire
+    auto cancel( void( *func )() ) -> void;
+
+    auto process() -> void;
+    auto untilNext() -> std::chrono::microseconds;
+} // namespace Scheduler
@@ -0,0 +1,152 @@
+#include <Arduino.h>
+
+#include <Wire.h>
+#include <esp_log.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "Peripherals.hpp"
+#include "Sampling.hpp"
+#include "SensorDrivers.hpp"
+#include "Bus.hpp"
+
+namespace SensorDrivers
+{
+    // Channels of the I2S sampler, already decimated on core 0
+    class InternalAdc : public Driver
+    {
+        private:
+            uint8_t channel;
+        public:
+            InternalAdc( uint8_t channel ) : channel{channel} {}
+
+            auto read() -> uint32_t override
+            {
+                return Sampling::get( this->channel );
+            }
+
+            auto readDirect() -> uint32_t override
+            {
+                return Sampling::read( this->channel );
+            }
+
+            auto interval() const -> std::chrono::milliseconds override
+            {
+                return std::chrono::milliseconds( 1000 / Sampling::outputRate );
+            }
+    };
+
+    // Single shot conversions on an external ADS1115, run as bus transactions one reading behind the caller
+    class Ads1115 : public Driver
+    {
+        private:
+            enum Registers
+            {
+                CONVERSION = 0x00,
+                CONFIG = 0x01
+            };
+
+            // OS start, single ended AINx, +-4.096 V, single shot, 860 SPS, comparator off
+            static constexpr uint16_t config{0x8000 | 0x4000 | 0x0200 | 0x0100 | 0x00E0 | 0x0003};
+            // 1 / 860 SPS plus the oscillator tolerance, in microseconds
+            static constexpr uint32_t conversionTime{1200};
+
+            uint8_t address;
+            uint8_t channel;
+            std::atomic<uint32_t> last;
+            std::atomic<bool> busy;
+
+            auto transfer( uint8_t reg, uint16_t* value ) -> bool
+            {
+                Wire.beginTransmission( this->address );
+                Wire.write( reg );
+                if ( Wire.endTransmission() != 0 or Wire.requestFrom( this->address, uint8_t{2} ) != 2 )
+                {
+                    return false;
+                }
+                *value = Wire.read() << 8;
+                *value |= Wire.read();
+                return true;
+            }
+
+        public:
+            auto convert() -> bool
+            {
+                const auto command{static_cast<uint16_t>( config | ( this->channel << 12 ) )};
+                Wire.beginTransmission( this->address );
+                Wire.write( Registers::CONFIG );
+                Wire.write( command >> 8 );
+                Wire.write( command & 0xFF );
+                if ( Wire.endTransmission() != 0 )
+                {
+                    return false;
+                }
+
+                delayMicroseconds( conversionTime );
+
+                auto value{uint16_t{}};
+                if ( not this->transfer( Registers::CONVERSION, &value ) )
+                {
+                    return false;
+                }
+
+                // Single ended inputs only go negative by noise around ground
+                const auto counts{static_cast<int16_t>( value )};
+                this->last = counts > 0 ? static_cast<uint32_t>( counts ) << Sampling::oversamplingBits : 0;
+                return true;
+            }
+
+        public:
+            Ads1115( uint8_t address, uint8_t channel ) : address{address}, channel{channel}, last{}, busy{false} {}
+
+            auto read() -> uint32_t override
+            {
+                if ( not this->busy.exchange( true ) )
+                {
+                    const auto queued{Bus::submit( Bus::Device::Ads1115, Bus::Priority::Normal, [this]()
+                    {
+                        const auto ok{this->convert()};
+                        this->busy = false;
+                        return ok;
+                    } )};
+                    if ( not queued )
+                    {
+                        this->busy = false;
+                    }
+                }
+                return this->last;
+            }
+
+            auto readDirect() -> uint32_t override
+            {
+                return this->convert() ? this->last.load() : 0;
+            }
+
+            auto interval() const -> std::chrono::milliseconds override
+            {
+                return std::chrono::milliseconds( 1000 );
+            }
+    };
+
+    auto create( const Configuration::Sensor& sensor ) -> std::unique_ptr<Driver>
+    {
+        switch ( sensor.driver )
+        {
+            case Configuration::Sensor::Driver::Internal:
+                if ( sensor.channel < Sampling::channelsCount )
+                {
+                    return std::unique_ptr<Driver> { new InternalAdc{sensor.channel} };
+                }
+                break;
+            case Configuration::Sensor::Driver::Ads1115:
+                if ( sensor.channel < Peripherals::ADS1115::CHANNELS and sensor.address >= Peripherals::ADS1115::I2C_ADDRESS and sensor.address < Peripherals::ADS1115::I2C_ADDRESS + 4 )
+                {
+                    return std::unique_ptr<Driver> { new Ads1115{sensor.address, sensor.channel} };
+                }
+                break;
+        }
+        log_e( "sensor %s has no channel %u on driver %u", sensor.name.data(), sensor.channel, sensor.driver );
+        return nullptr;
+    }
+} // namespace SensorDrivers
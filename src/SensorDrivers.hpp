@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include <chrono>
+#include <memory>
+
+#include "Configuration.hpp"
+
+namespace SensorDrivers
+{
+    // Raw readings of one sensor, in ADC counts carrying Sampling::oversamplingBits fractional bits
+    class Driver
+    {
+        public:
+            virtual ~Driver() = default;
+            virtual auto read() -> uint32_t = 0;
+            // Blocking reading straight from the hardware, for the wake-up path where neither the sampler nor the bus run
+            virtual auto readDirect() -> uint32_t = 0;
+            virtual auto interval() const -> std::chrono::milliseconds = 0;
+    };
+
+    // Null when the sensor names a channel its driver does not have
+    auto create( const Configuration::Sensor& sensor ) -> std::unique_ptr<Driver>;
+} // namespace SensorDrivers
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Fixed point per sample arithmetic of Infos, kept apart from the drivers so it builds on the host
+namespace SensorKernels
+{
+    static constexpr uint8_t gainBits{24};
+    static constexpr uint8_t filterBits{16};
+    static constexpr uint8_t factorBits{32};
+
+    // Q24 affine map from oversampled counts to centi-kPa
+    struct Map
+    {
+        int64_t gain;
+        int64_t offset;
+    };
+
+    // Folds calibration, zero offset and sensitivity into one map, counts carry fractionalBits of oversampling
+    template<typename Model>
+    inline auto calibrate( double angularCoefficient, double linearCoefficient, uint8_t fractionalBits ) -> Map
+    {
+        static constexpr double scale{100.0 / Model::sensitivity * ( 1 << gainBits )};
+        static constexpr double zeroOffset{Model::zeroOffset};
+
+        return Map{llround( angularCoefficient / ( 1 << fractionalBits ) * scale ), llround( ( linearCoefficient + zeroOffset ) * scale )};
+    }
+
+    // The model range is a compile time constant
+    template<typename Model>
+    inline auto convert( const Map& map, uint32_t counts ) -> int32_t
+    {
+        static constexpr int32_t max{static_cast<int32_t>( Model::max * 100 )};
+
+        const auto centi{static_cast<int32_t>( ( counts * map.gain + map.offset + ( int64_t{1} << ( gainBits - 1 ) ) ) >> gainBits )};
+        return std::min( std::max( centi, int32_t{0} ), max );
+    }
+
+    // Counts that convert() maps to centi, 0 for a map that does not rise
+    inline auto invert( const Map& map, int32_t centi ) -> uint32_t
+    {
+        if ( map.gain <= 0 )
+        {
+            return 0;
+        }
+        const auto counts{( ( static_cast<int64_t>( centi ) << gainBits ) - map.offset ) / map.gain};
+        return static_cast<uint32_t>( std::max( counts, int64_t{0} ) );
+    }
+
+    // Exponential moving average over about samples values, state in Q16 and weight 2 / ( N + 1 ) in Q32
+    struct Ema
+    {
+        int64_t factor;
+        int64_t filtered;
+        bool seeded;
+    };
+
+    inline auto weight( double samples ) -> int64_t
+    {
+        return llround( 2.0 / ( samples + 1.0 ) * static_cast<double>( int64_t{1} << factorBits ) );
+    }
+
+    // The first value after a reset seeds the average
+    inline auto filter( Ema* ema, int32_t centi ) -> int32_t
+    {
+        const auto value{static_cast<int64_t>( centi ) << filterBits};
+        if ( ema->seeded )
+        {
+            ema->filtered += ( ( value - ema->filtered ) * ema->factor ) >> factorBits;
+        }
+        else
+        {
+            ema->filtered = value;
+            ema->seeded = true;
+        }
+        return static_cast<int32_t>( ( ema->filtered + ( int64_t{1} << ( filterBits - 1 ) ) ) >> filterBits );
+    }
+} // namespace SensorKernels
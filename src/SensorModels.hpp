@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace SensorModels
+{
+    // Freescale MPX5xxx family: Vout = Vs * ( sensitivity * P + 0.04 ), typical datasheet values
+    struct Mpx5xxx
+    {
+        static constexpr double zeroOffset{-0.2000};
+    };
+
+    struct MPX5050 : Mpx5xxx
+    {
+        static constexpr double max{50.0};
+        static constexpr double sensitivity{0.0900};
+    };
+
+    struct MPX5100 : Mpx5xxx
+    {
+        static constexpr double max{100.0};
+        static constexpr double sensitivity{0.0450};
+    };
+
+    struct MPX5500 : Mpx5xxx
+    {
+        static constexpr double max{500.0};
+        static constexpr double sensitivity{0.0090};
+    };
+
+    struct MPX5700 : Mpx5xxx
+    {
+        static constexpr double max{700.0};
+        static constexpr double sensitivity{0.0064};
+    };
+} // namespace SensorModels
@@ -0,0 +1,266 @@
+#include <Arduino.h>
+
+#include <BME280I2C.h>
+#include <Wire.h>
+#include <esp_log.h>
+#include <esp_sleep.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+
+#include "Configuration.hpp"
+#include "Database.hpp"
+#include "Infos.hpp"
+#include "Peripherals.hpp"
+#include "Sampling.hpp"
+#include "SensorDrivers.hpp"
+#include "SleepLog.hpp"
+#include "Ulp.hpp"
+
+namespace SleepLog
+{
+    struct Input
+    {
+        Configuration::Sensor::Driver driver;
+        uint8_t address;
+        uint8_t channel;
+        bool enabled;
+    };
+
+    // Sensors are kept as raw driver counts, converting them needs the calibration that only a full boot loads
+    struct Record
+    {
+        uint32_t time;
+        float temperature;
+        float humidity;
+        float pressure;
+        std::array<uint32_t, Configuration::maxSensors> counts;
+    };
+
+    static constexpr size_t capacity{48};
+    static constexpr size_t drainThreshold{capacity - capacity / 8};
+    static constexpr uint32_t unread{UINT32_MAX};
+    // The ULP reads the internal channels this often, which bounds the alarm latency while asleep
+    static constexpr auto ulpPeriod{std::chrono::seconds( 1 )};
+    static_assert( std::chrono::minutes( Configuration::AutoSleepWakeUp::maxLogInterval ) / ulpPeriod <= UINT16_MAX, "ULP batch overflows" );
+
+    // RTC slow memory keeps its contents through deep sleep, the buffer takes about 4 KB of its 8 KB
+    static RTC_DATA_ATTR bool armed{false};
+    static RTC_DATA_ATTR uint16_t interval{};
+    static RTC_DATA_ATTR bool ulpSampling{false};
+    static RTC_DATA_ATTR uint8_t inputsCount{};
+    static RTC_DATA_ATTR std::array<Input, Configuration::maxSensors> inputs{};
+    static RTC_DATA_ATTR size_t recordsFirst{};
+    static RTC_DATA_ATTR size_t recordsCount{};
+    static RTC_DATA_ATTR std::array<Record, capacity> records{};
+    static RTC_DATA_ATTR std::array<uint16_t, Sampling::channelsCount> thresholds{};
+
+    static bool drainPending{false};
+    // A drain boot sleeps again before Infos publishes anything, its readings are the last record drained
+    static bool drained{false};
+    static auto latest{std::array<uint32_t, Configuration::maxSensors> {}};
+
+    // Without the ULP a timer wakes on the next wall clock multiple of the interval, with it the end of its batch does.
+    // The DS3231 alarm on SQW still wakes for the day
+    static auto enableWakeUps() -> void
+    {
+        if ( not ulpSampling )
+        {
+            const auto period{std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::minutes( interval ) )};
+            const auto now{std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() )};
+            esp_sleep_enable_timer_wakeup( ( period - now % period ).count() );
+        }
+        esp_sleep_enable_ext0_wakeup( static_cast<gpio_num_t>( Peripherals::DS3231::SQW_INT ), 0 );
+    }
+
+    // Mean of the ULP batch, in the oversampled counts Sampling::get() delivers
+    static auto batchMean( uint8_t channel ) -> uint32_t
+    {
+        const auto count{Ulp::count()};
+        if ( count == 0 )
+        {
+            return Sampling::read( channel );
+        }
+        return ( static_cast<uint64_t>( Ulp::get( channel ).sum ) << Sampling::oversamplingBits ) / count;
+    }
+
+    static auto append( const Record& record ) -> void
+    {
+        // Should the drain keep failing the oldest samples go first
+        if ( recordsCount == capacity )
+        {
+            recordsFirst = ( recordsFirst + 1 ) % capacity;
+            recordsCount--;
+        }
+        records[( recordsFirst + recordsCount ) % capacity] = record;
+        recordsCount++;
+    }
+
+    // Nothing else runs yet, so Wire and the ADC are used directly instead of through Bus and Sampling
+    static auto sample() -> void
+    {
+        pinMode( Peripherals::PRF_CTL, OUTPUT );
+        digitalWrite( Peripherals::PRF_CTL, LOW );
+        Wire.begin();
+
+        auto record{Record{static_cast<uint32_t>( std::time( nullptr ) ), NAN, NAN, NAN, {}}};
+        record.counts.fill( unread );
+
+        auto bme{BME280I2C{}};
+        if ( bme.begin() )
+        {
+            bme.read( record.pressure, record.temperature, record.humidity, BME280::TempUnit_Celsius, BME280::PresUnit_hPa );
+        }
+
+        for ( size_t n{0}; n < inputsCount; ++n )
+        {
+            if ( not inputs[n].enabled )
+            {
+                continue;
+            }
+            if ( ulpSampling and inputs[n].driver == Configuration::Sensor::Driver::Internal and inputs[n].channel < Sampling::channelsCount )
+            {
+                record.counts[n] = batchMean( inputs[n].channel );
+                continue;
+            }
+
+            auto sensor{Configuration::Sensor{}};
+            sensor.driver = inputs[n].driver;
+            sensor.address = inputs[n].address;
+            sensor.channel = inputs[n].channel;
+            const auto driver{SensorDrivers::create( sensor )};
+            if ( driver != nullptr )
+            {
+                record.counts[n] = driver->readDirect();
+            }
+        }
+
+        append( record );
+    }
+
+    auto resume() -> void
+    {
+        const auto cause{esp_sleep_get_wakeup_cause()};
+        if ( not armed or ( cause != ESP_SLEEP_WAKEUP_TIMER and cause != ESP_SLEEP_WAKEUP_ULP ) )
+        {
+            armed = false;
+            return;
+        }
+        // A tank dropping below its alarm level gets a full boot, which raises the alarm as when awake
+        if ( cause == ESP_SLEEP_WAKEUP_ULP and Ulp::alarmed() )
+        {
+            log_d( "ulp alarm" );
+            armed = false;
+            return;
+        }
+
+        sample();
+        if ( recordsCount < drainThreshold )
+        {
+            if ( ulpSampling )
+            {
+                Ulp::restart();
+            }
+            enableWakeUps();
+            esp_deep_sleep_start();
+        }
+        drainPending = true;
+    }
+
+    auto draining() -> bool
+    {
+        return drainPending;
+    }
+
+    auto drain() -> void
+    {
+        log_d( "draining %u samples", recordsCount );
+
+        const auto centi{[]( float value )
+        {
+            return round( value * 100 ) / 100;
+        }};
+
+        for ( ; recordsCount > 0; recordsCount-- )
+        {
+            const auto& record{records[recordsFirst]};
+
+            auto sensorData{Database::SensorData
+            {
+                0,
+                static_cast<std::time_t>( record.time ),
+                centi( record.temperature ),
+                centi( record.humidity ),
+                centi( record.pressure ),
+                {}
+            }};
+            sensorData.sensors.reserve( cfg.sensors.size() );
+            for ( size_t n{0}; n < cfg.sensors.size(); ++n )
+            {
+                const auto counts{n < record.counts.size() ? record.counts[n] : unread};
+                sensorData.sensors.push_back( counts != unread ? Infos::convert( n, counts ) : NAN );
+            }
+            Database::append( sensorData );
+            latest = record.counts;
+            drained = true;
+
+            recordsFirst = ( recordsFirst + 1 ) % capacity;
+        }
+    }
+
+    auto arm() -> void
+    {
+        interval = cfg.autoSleepWakeUp.logInterval;
+        if ( interval == 0 )
+        {
+            armed = false;
+            return;
+        }
+
+        const auto snapshot{Infos::Snapshot::get()};
+        auto next{std::array<uint16_t, Sampling::channelsCount> {}};
+
+        ulpSampling = false;
+        inputsCount = std::min( cfg.sensors.size(), size_t{Configuration::maxSensors} );
+        for ( size_t n{0}; n < inputsCount; ++n )
+        {
+            const auto& sensor{cfg.sensors[n]};
+            inputs[n] = Input{sensor.driver, sensor.address, sensor.channel, sensor.enabled};
+
+            if ( not sensor.enabled or sensor.driver != Configuration::Sensor::Driver::Internal or sensor.channel >= Sampling::channelsCount )
+            {
+                continue;
+            }
+            ulpSampling = true;
+
+            if ( not sensor.alarm.enabled )
+            {
+                continue;
+            }
+            // Whether the channel is already in alarm comes from the published readings, or from the drained ones
+            const auto level{sensor.min + sensor.alarm.value / 100.0 * ( sensor.max - sensor.min )};
+            auto current{Ulp::unknown};
+            if ( n < snapshot.count )
+            {
+                current = Infos::invert( n, snapshot.getSensor( n ) ) >> Sampling::oversamplingBits;
+            }
+            else if ( drained and latest[n] != unread )
+            {
+                current = latest[n] >> Sampling::oversamplingBits;
+            }
+            const auto counts{std::min( Infos::invert( n, level ) >> Sampling::oversamplingBits, uint32_t{0x0FFF} )};
+            next[sensor.channel] = Ulp::threshold( counts, current, thresholds[sensor.channel] );
+        }
+        thresholds = next;
+
+        if ( ulpSampling )
+        {
+            Ulp::start( thresholds, ulpPeriod, std::chrono::minutes( interval ) / ulpPeriod );
+        }
+
+        armed = true;
+        enableWakeUps();
+    }
+} // namespace SleepLog
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace SleepLog
+{
+    // First thing on boot: a timer wake-up while logging overnight samples the sensors into RTC memory and goes
+    // straight back to deep sleep, it only returns when the buffer is nearly full or on any other kind of boot
+    auto resume() -> void;
+    // The boot was woken at night only to move the buffer to storage
+    auto draining() -> bool;
+    // Moves the buffered samples into the database, needs Database and Infos initialized
+    auto drain() -> void;
+    // Arms the sampling timer right before deep sleep, the DS3231 wake-up alarm still ends the night
+    auto arm() -> void;
+} // namespace SleepLog
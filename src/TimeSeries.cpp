@@ -0,0 +1,286 @@
+#include <Arduino.h>
+
+#include <FS.h>
+#include <SD.h>
+#include <esp_log.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <atomic>
+
+#include "Configuration.hpp"
+#include "TimeSeries.hpp"
+#include "TimeSeriesCodec.hpp"
+
+namespace TimeSeries
+{
+    static constexpr auto path{"/sensors_data_v2.tsdb"};
+
+    static_assert( valuesMax >= 3 + Configuration::maxSensors, "blocks must hold every configured sensor" );
+
+    static File file{};
+    static SemaphoreHandle_t lock{};
+    static Block current{};
+    static State writer{};
+    static uint32_t currentIndex{};
+    static std::atomic<uint32_t> persisted{};
+    static int64_t nextId{1};
+
+    static auto columns( const Database::SensorData& sensorData ) -> uint16_t
+    {
+        return 3 + std::min( sensorData.sensors.size(), size_t{Configuration::maxSensors} );
+    }
+
+    static auto toValues( const Database::SensorData& sensorData ) -> std::array<uint64_t, valuesMax>
+    {
+        auto values{std::array<uint64_t, valuesMax> {}};
+        values[0] = toBits( sensorData.temperature );
+        values[1] = toBits( sensorData.humidity );
+        values[2] = toBits( sensorData.pressure );
+        for ( size_t n{3}; n < columns( sensorData ); ++n )
+        {
+            values[n] = toBits( sensorData.sensors[n - 3] );
+        }
+        return values;
+    }
+
+    static auto fromValues( const std::array<uint64_t, valuesMax>& values, uint16_t columns, Database::SensorData* sensorData ) -> void
+    {
+        sensorData->temperature = fromBits( values[0] );
+        sensorData->humidity = fromBits( values[1] );
+        sensorData->pressure = fromBits( values[2] );
+        sensorData->sensors.resize( columns - 3 );
+        for ( size_t n{3}; n < columns; ++n )
+        {
+            sensorData->sensors[n - 3] = fromBits( values[n] );
+        }
+    }
+
+    static auto load( File& handle, uint32_t index, Block* block ) -> bool
+    {
+        xSemaphoreTake( lock, portMAX_DELAY );
+        const auto loaded{handle.seek( index * blockSize ) and handle.read( reinterpret_cast<uint8_t*>( block ), blockSize ) == blockSize};
+        xSemaphoreGive( lock );
+        return loaded and block->header.magic == magic and block->header.bits <= payloadBits and block->header.columns >= 3 and block->header.columns <= valuesMax;
+    }
+
+    class Reader : public Database::Source
+    {
+        private:
+            File handle;
+            uint32_t blocks;
+            uint32_t index;
+            Block block;
+            State state;
+            int64_t id;
+            int64_t start;
+            int64_t end;
+            Database::Cursor after;
+            size_t remaining;
+
+            // First block whose last sample can still match, binary searched on the on-disk block headers
+            auto seek() -> uint32_t
+            {
+                auto first{uint32_t{0}};
+                auto last{this->blocks};
+                while ( first < last )
+                {
+                    const auto middle{first + ( last - first ) / 2};
+                    if ( not load( this->handle, middle, &this->block ) )
+                    {
+                        return middle;
+                    }
+
+                    const auto lastId{this->block.header.firstId + this->block.header.count - 1};
+                    const auto lastTime{this->block.header.firstTime + this->block.header.span};
+                    if ( lastId < this->id or lastTime < this->start or ( this->after and lastTime < this->after.dateTime ) )
+                    {
+                        first = middle + 1;
+                    }
+                    else
+                    {
+                        last = middle;
+                    }
+                }
+                return first;
+            }
+
+        public:
+            Reader( int64_t id, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, Database::Cursor after, size_t limit )
+                : handle{SD.open( path, FILE_READ )},
+                  blocks{persisted},
+                  index{0},
+                  block{},
+                  state{},
+                  id{id},
+                  start{start == std::chrono::system_clock::time_point::min() ? std::numeric_limits<int64_t>::min() : std::chrono::system_clock::to_time_t( start )},
+                  end{end == std::chrono::system_clock::time_point::max() ? std::numeric_limits<int64_t>::max() : std::chrono::system_clock::to_time_t( end )},
+                  after{after},
+                  remaining{limit > 0 ? limit : std::numeric_limits<size_t>::max()}
+            {
+                if ( not this->handle )
+                {
+                    this->blocks = 0;
+                }
+                this->index = this->seek();
+                this->block.header.count = 0;
+            }
+
+            ~Reader() override
+            {
+                this->handle.close();
+            }
+
+            auto next( Database::SensorData* sensorData ) -> bool override
+            {
+                while ( this->remaining > 0 )
+                {
+                    if ( this->state.count >= this->block.header.count )
+                    {
+                        if ( this->index >= this->blocks or not load( this->handle, this->index, &this->block ) )
+                        {
+                            return false;
+                        }
+                        this->index++;
+                        this->state = State{};
+                    }
+
+                    decode( this->block, &this->state );
+
+                    const auto sampleId{this->block.header.firstId + this->state.count - 1};
+                    if ( this->state.time > this->end )
+                    {
+                        return false;
+                    }
+                    if ( sampleId < this->id or this->state.time < this->start )
+                    {
+                        continue;
+                    }
+                    if ( this->after and ( this->state.time < this->after.dateTime or ( this->state.time == this->after.dateTime and sampleId <= this->after.id ) ) )
+                    {
+                        continue;
+                    }
+
+                    sensorData->id = sampleId;
+                    sensorData->dateTime = this->state.time;
+                    fromValues( this->state.values, this->block.header.columns, sensorData );
+                    this->remaining--;
+                    return true;
+                }
+                return false;
+            }
+    };
+
+    static auto recover() -> void
+    {
+        log_d( "begin" );
+
+        currentIndex = file.size() / blockSize;
+        current = Block{};
+        writer = State{};
+
+        auto last{Block{}};
+        while ( currentIndex > 0 and not load( file, currentIndex - 1, &last ) )
+        {
+            log_e( "block %u corrupted, overwriting it", currentIndex - 1 );
+            currentIndex--;
+        }
+        persisted = currentIndex;
+
+        if ( currentIndex > 0 )
+        {
+            nextId = last.header.firstId + last.header.count;
+            if ( last.header.bits + sampleMaxBits( last.header.columns ) <= payloadBits )
+            {
+                // Reopen the partial tail block so appends continue in it
+                currentIndex--;
+                current = last;
+                for ( uint16_t n{0}; n < last.header.count; ++n )
+                {
+                    decode( last, &writer );
+                }
+            }
+        }
+
+        log_d( "blocks = %u, next id = %lld", currentIndex, nextId );
+        log_d( "end" );
+    }
+
+    auto init() -> void
+    {
+        log_d( "begin" );
+
+        lock = xSemaphoreCreateMutex();
+
+        if ( not SD.exists( path ) )
+        {
+            auto created{SD.open( path, FILE_WRITE )};
+            created.close();
+        }
+
+        file = SD.open( path, "r+" );
+        if ( not file )
+        {
+            log_e( "file error" );
+            std::abort();
+        }
+
+        recover();
+
+        log_d( "end" );
+    }
+
+    auto append( const Database::SensorData& sensorData ) -> int64_t
+    {
+        const auto sampleColumns{columns( sensorData )};
+
+        // A changed sensor count also closes the block, each block has a single layout
+        if ( writer.count > 0 and ( writer.position + sampleMaxBits( sampleColumns ) > payloadBits or current.header.columns != sampleColumns ) )
+        {
+            if ( not sync() )
+            {
+                return 0;
+            }
+            currentIndex++;
+            current = Block{};
+            writer = State{};
+        }
+
+        if ( writer.count == 0 )
+        {
+            current.header.firstId = nextId;
+            current.header.columns = sampleColumns;
+        }
+
+        encode( &current, &writer, sensorData.dateTime, toValues( sensorData ) );
+        return nextId++;
+    }
+
+    auto sync() -> bool
+    {
+        if ( writer.count == 0 )
+        {
+            return true;
+        }
+
+        xSemaphoreTake( lock, portMAX_DELAY );
+        const auto written{file.seek( currentIndex * blockSize ) and file.write( reinterpret_cast<const uint8_t*>( &current ), blockSize ) == blockSize};
+        file.flush();
+        xSemaphoreGive( lock );
+
+        if ( not written )
+        {
+            log_e( "block %u write error", currentIndex );
+            return false;
+        }
+
+        persisted = std::max<uint32_t>( persisted, currentIndex + 1 );
+        return true;
+    }
+
+    auto select( int64_t id, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, Database::Cursor after, size_t limit ) -> std::unique_ptr<Database::Source>
+    {
+        return std::unique_ptr<Database::Source> { new Reader{id, start, end, after, limit} };
+    }
+} // namespace TimeSeries
\ No newline at end of file
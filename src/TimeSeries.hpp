@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+#include <chrono>
+#include <memory>
+
+#include "Database.hpp"
+
+namespace TimeSeries
+{
+    auto init() -> void;
+    auto append( const Database::SensorData& sensorData ) -> int64_t;
+    auto sync() -> bool;
+    auto select( int64_t id, std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end, Database::Cursor after, size_t limit ) -> std::unique_ptr<Database::Source>;
+} // namespace TimeSeries
\ No newline at end of file
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// Block layout and sample codec of the compressed engine, free of any file or SD access so the host tests can run it
+namespace TimeSeries
+{
+    // Blocks carry their own column count, so the file survives sensors being added or removed
+    static constexpr uint32_t magic{0x32544357}; // "WCT2"
+    static constexpr size_t blockSize{512};
+    // Temperature, humidity, pressure and up to Configuration::maxSensors sensors
+    static constexpr size_t valuesMax{3 + 16};
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t count;
+        uint16_t bits;
+        int64_t firstId;
+        int64_t firstTime;
+        uint32_t span;
+        uint16_t columns;
+        uint16_t reserved;
+    };
+
+    static constexpr size_t payloadBits{( blockSize - sizeof( Header ) ) * 8};
+
+    static constexpr auto sampleMaxBits( size_t columns ) -> size_t
+    {
+        return 4 + 64 + columns * ( 2 + 5 + 6 + 64 );
+    }
+
+    static_assert( sampleMaxBits( valuesMax ) <= payloadBits, "a block must hold at least one sample" );
+
+    struct Block
+    {
+        Header header;
+        std::array<uint8_t, blockSize - sizeof( Header )> payload;
+    };
+
+    static_assert( sizeof( Block ) == blockSize, "block must fill one SD sector" );
+
+    struct State
+    {
+        int64_t time;
+        int64_t delta;
+        std::array<uint64_t, valuesMax> values;
+        std::array<uint8_t, valuesMax> leading;
+        std::array<uint8_t, valuesMax> trailing;
+        uint16_t position;
+        uint16_t count;
+    };
+
+    inline auto write( Block* block, uint16_t* position, uint64_t value, uint8_t bits ) -> void
+    {
+        for ( int8_t n{static_cast<int8_t>( bits - 1 )}; n >= 0; --n )
+        {
+            const auto byte{*position / 8};
+            const auto bit{7 - *position % 8};
+            if ( ( value >> n ) & 1 )
+            {
+                block->payload[byte] |= ( 1 << bit );
+            }
+            else
+            {
+                block->payload[byte] &= ~( 1 << bit );
+            }
+            ( *position )++;
+        }
+    }
+
+    inline auto read( const Block& block, uint16_t* position, uint8_t bits ) -> uint64_t
+    {
+        auto value{uint64_t{}};
+        for ( uint8_t n{0}; n < bits; ++n )
+        {
+            const auto byte{*position / 8};
+            const auto bit{7 - *position % 8};
+            value = ( value << 1 ) | ( ( block.payload[byte] >> bit ) & 1 );
+            ( *position )++;
+        }
+        return value;
+    }
+
+    inline auto readSigned( const Block& block, uint16_t* position, uint8_t bits ) -> int64_t
+    {
+        const auto value{read( block, position, bits )};
+        if ( bits < 64 and ( value >> ( bits - 1 ) ) & 1 )
+        {
+            return static_cast<int64_t>( value | ( ~uint64_t{} << bits ) );
+        }
+        return static_cast<int64_t>( value );
+    }
+
+    inline auto toBits( double value ) -> uint64_t
+    {
+        auto bits{uint64_t{}};
+        std::memcpy( &bits, &value, sizeof( bits ) );
+        return bits;
+    }
+
+    inline auto fromBits( uint64_t bits ) -> double
+    {
+        auto value{double{}};
+        std::memcpy( &value, &bits, sizeof( value ) );
+        return value;
+    }
+
+    // Delta-of-delta timestamps and XOR values, as described for Facebook's Gorilla
+    inline auto encode( Block* block, State* state, int64_t time, const std::array<uint64_t, valuesMax>& values ) -> void
+    {
+        const auto columns{block->header.columns};
+        if ( state->count == 0 )
+        {
+            block->header.firstTime = time;
+            for ( size_t n{0}; n < columns; ++n )
+            {
+                write( block, &state->position, values[n], 64 );
+                state->leading[n] = std::numeric_limits<uint8_t>::max();
+                state->trailing[n] = 0;
+            }
+            state->delta = 0;
+        }
+        else
+        {
+            const auto delta{time - state->time};
+            const auto deltaOfDelta{delta - state->delta};
+            if ( deltaOfDelta == 0 )
+            {
+                write( block, &state->position, 0b0, 1 );
+            }
+            else if ( deltaOfDelta >= -64 and deltaOfDelta <= 63 )
+            {
+                write( block, &state->position, 0b10, 2 );
+                write( block, &state->position, deltaOfDelta, 7 );
+            }
+            else if ( deltaOfDelta >= -256 and deltaOfDelta <= 255 )
+            {
+                write( block, &state->position, 0b110, 3 );
+                write( block, &state->position, deltaOfDelta, 9 );
+            }
+            else if ( deltaOfDelta >= -2048 and deltaOfDelta <= 2047 )
+            {
+                write( block, &state->position, 0b1110, 4 );
+                write( block, &state->position, deltaOfDelta, 12 );
+            }
+            else
+            {
+                write( block, &state->position, 0b1111, 4 );
+                write( block, &state->position, deltaOfDelta, 64 );
+            }
+            state->delta = delta;
+
+            for ( size_t n{0}; n < columns; ++n )
+            {
+                const auto xored{values[n] ^ state->values[n]};
+                if ( xored == 0 )
+                {
+                    write( block, &state->position, 0b0, 1 );
+                    continue;
+                }
+
+                const auto leading{static_cast<uint8_t>( std::min( __builtin_clzll( xored ), 31 ) )};
+                const auto trailing{static_cast<uint8_t>( __builtin_ctzll( xored ) )};
+                if ( state->leading[n] != std::numeric_limits<uint8_t>::max() and leading >= state->leading[n] and trailing >= state->trailing[n] )
+                {
+                    write( block, &state->position, 0b10, 2 );
+                    write( block, &state->position, xored >> state->trailing[n], 64 - state->leading[n] - state->trailing[n] );
+                }
+                else
+                {
+                    const auto length{static_cast<uint8_t>( 64 - leading - trailing )};
+                    write( block, &state->position, 0b11, 2 );
+                    write( block, &state->position, leading, 5 );
+                    write( block, &state->position, length - 1, 6 );
+                    write( block, &state->position, xored >> trailing, length );
+                    state->leading[n] = leading;
+                    state->trailing[n] = trailing;
+                }
+            }
+        }
+
+        state->time = time;
+        state->values = values;
+        state->count++;
+
+        block->header.magic = magic;
+        block->header.count = state->count;
+        block->header.bits = state->position;
+        block->header.span = time - block->header.firstTime;
+    }
+
+    inline auto decode( const Block& block, State* state ) -> void
+    {
+        const auto columns{block.header.columns};
+        if ( state->count == 0 )
+        {
+            state->time = block.header.firstTime;
+            for ( size_t n{0}; n < columns; ++n )
+            {
+                state->values[n] = read( block, &state->position, 64 );
+                state->leading[n] = std::numeric_limits<uint8_t>::max();
+                state->trailing[n] = 0;
+            }
+            state->delta = 0;
+        }
+        else
+        {
+            auto deltaOfDelta{int64_t{}};
+            if ( read( block, &state->position, 1 ) == 0b0 )
+            {
+                deltaOfDelta = 0;
+            }
+            else if ( read( block, &state->position, 1 ) == 0b0 )
+            {
+                deltaOfDelta = readSigned( block, &state->position, 7 );
+            }
+            else if ( read( block, &state->position, 1 ) == 0b0 )
+            {
+                deltaOfDelta = readSigned( block, &state->position, 9 );
+            }
+            else if ( read( block, &state->position, 1 ) == 0b0 )
+            {
+                deltaOfDelta = readSigned( block, &state->position, 12 );
+            }
+            else
+            {
+                deltaOfDelta = readSigned( block, &state->position, 64 );
+            }
+            state->delta += deltaOfDelta;
+            state->time += state->delta;
+
+            for ( size_t n{0}; n < columns; ++n )
+            {
+                if ( read( block, &state->position, 1 ) == 0b0 )
+                {
+                    continue;
+                }
+
+                if ( read( block, &state->position, 1 ) == 0b0 )
+                {
+                    const auto length{64 - state->leading[n] - state->trailing[n]};
+                    state->values[n] ^= read( block, &state->position, length ) << state->trailing[n];
+                }
+                else
+                {
+                    const auto leading{static_cast<uint8_t>( read( block, &state->position, 5 ) )};
+                    const auto length{static_cast<uint8_t>( read( block, &state->position, 6 ) + 1 )};
+                    const auto trailing{static_cast<uint8_t>( 64 - leading - length )};
+                    state->values[n] ^= read( block, &state->position, length ) << trailing;
+                    state->leading[n] = leading;
+                    state->trailing[n] = trailing;
+                }
+            }
+        }
+
+        state->count++;
+    }
+} // namespace TimeSeries
@@ -0,0 +1,209 @@
+#include <Arduino.h>
+
+#include <driver/adc.h>
+#include <esp32/ulp.h>
+#include <esp_log.h>
+#include <esp_sleep.h>
+#include <cstdlib>
+#include <vector>
+
+#include "Sampling.hpp"
+#include "Ulp.hpp"
+
+namespace Ulp
+{
+    // Word offsets in RTC slow memory, the data comes first and the program right after it. Both have to fit the
+    // 512 bytes CONFIG_ULP_COPROC_RESERVE_MEM keeps ahead of the RTC_DATA_ATTR variables
+    enum Globals
+    {
+        Count,
+        Batch,
+        GlobalsCount
+    };
+
+    enum Channel
+    {
+        Min,
+        Max,
+        SumLow,
+        SumHigh,
+        Threshold,
+        ChannelWords
+    };
+
+    static constexpr uint32_t programOffset{GlobalsCount + ChannelWords * Sampling::channelsCount};
+    static constexpr uint32_t reservedWords{512 / sizeof( uint32_t )};
+
+    enum Labels
+    {
+        WakeLabel = 1,
+        HaltLabel,
+        // Each channel block numbers its own labels from here
+        ChannelLabels = 8
+    };
+
+    // The ULP only stores the lower half word, the upper one holds the address of the store instruction
+    static auto word( uint32_t offset ) -> uint16_t
+    {
+        return RTC_SLOW_MEM[offset] & 0xFFFF;
+    }
+
+    static auto channelOffset( uint8_t index ) -> uint32_t
+    {
+        return GlobalsCount + ChannelWords * index;
+    }
+
+    // Comparisons go through the ALU overflow flag: a - b sets it exactly when a < b, and so does a carry out of an add
+    static auto channelProgram( uint8_t index ) -> std::vector<ulp_insn_t>
+    {
+        const auto base{channelOffset( index )};
+        const auto label{static_cast<uint16_t>( ChannelLabels * ( index + 1 ) )};
+
+        return
+        {
+            I_ADC( R1, 0, Sampling::channel( index ) ),
+
+            I_LD( R2, R3, base + Min ),
+            I_SUBR( R0, R1, R2 ),
+            M_BXF( label + 0 ),
+            M_BX( label + 1 ),
+            M_LABEL( label + 0 ),
+            I_ST( R1, R3, base + Min ),
+            M_LABEL( label + 1 ),
+
+            I_LD( R2, R3, base + Max ),
+            I_SUBR( R0, R2, R1 ),
+            M_BXF( label + 2 ),
+            M_BX( label + 3 ),
+            M_LABEL( label + 2 ),
+            I_ST( R1, R3, base + Max ),
+            M_LABEL( label + 3 ),
+
+            I_LD( R2, R3, base + SumLow ),
+            I_ADDR( R2, R2, R1 ),
+            I_ST( R2, R3, base + SumLow ),
+            M_BXF( label + 4 ),
+            M_BX( label + 5 ),
+            M_LABEL( label + 4 ),
+            I_LD( R2, R3, base + SumHigh ),
+            I_ADDI( R2, R2, 1 ),
+            I_ST( R2, R3, base + SumHigh ),
+            M_LABEL( label + 5 ),
+
+            I_LD( R2, R3, base + Threshold ),
+            I_SUBR( R0, R1, R2 ),
+            M_BXF( WakeLabel ),
+        };
+    }
+
+    static auto load() -> void
+    {
+        auto program{std::vector<ulp_insn_t>{I_MOVI( R3, 0 )}};
+        for ( uint8_t index{0}; index < Sampling::channelsCount; ++index )
+        {
+            const auto block{channelProgram( index )};
+            program.insert( program.end(), block.begin(), block.end() );
+        }
+        const auto tail{std::vector<ulp_insn_t>
+        {
+            I_LD( R0, R3, Count ),
+            I_ADDI( R0, R0, 1 ),
+            I_ST( R0, R3, Count ),
+            I_LD( R2, R3, Batch ),
+            I_SUBR( R0, R0, R2 ),
+            M_BXF( HaltLabel ),
+
+            // The timer stays off until the main CPU has collected the batch
+            M_LABEL( WakeLabel ),
+            I_WAKE(),
+            I_END(),
+            I_HALT(),
+
+            M_LABEL( HaltLabel ),
+            I_HALT()
+        }};
+        program.insert( program.end(), tail.begin(), tail.end() );
+
+        auto size{program.size()};
+        if ( programOffset + size > reservedWords or
+                ulp_process_macros_and_load( programOffset, program.data(), &size ) != ESP_OK )
+        {
+            log_e( "ulp load error" );
+            std::abort();
+        }
+    }
+
+    static auto clear() -> void
+    {
+        RTC_SLOW_MEM[Count] = 0;
+        for ( uint8_t index{0}; index < Sampling::channelsCount; ++index )
+        {
+            const auto base{channelOffset( index )};
+            RTC_SLOW_MEM[base + Min] = 0xFFFF;
+            RTC_SLOW_MEM[base + Max] = 0;
+            RTC_SLOW_MEM[base + SumLow] = 0;
+            RTC_SLOW_MEM[base + SumHigh] = 0;
+        }
+    }
+
+    auto start( const std::array<uint16_t, Sampling::channelsCount>& thresholds, std::chrono::milliseconds period, uint16_t batch ) -> void
+    {
+        adc1_config_width( ADC_WIDTH_BIT_12 );
+        for ( uint8_t index{0}; index < Sampling::channelsCount; ++index )
+        {
+            adc1_config_channel_atten( Sampling::channel( index ), ADC_ATTEN_DB_11 );
+            RTC_SLOW_MEM[channelOffset( index ) + Threshold] = thresholds[index];
+        }
+        adc1_ulp_enable();
+
+        RTC_SLOW_MEM[Batch] = batch;
+        load();
+        ulp_set_wakeup_period( 0, std::chrono::duration_cast<std::chrono::microseconds>( period ).count() );
+        restart();
+    }
+
+    auto restart() -> void
+    {
+        clear();
+        ulp_run( programOffset );
+        esp_sleep_enable_ulp_wakeup();
+    }
+
+    auto count() -> uint16_t
+    {
+        return word( Count );
+    }
+
+    auto get( uint8_t index ) -> Accumulator
+    {
+        const auto base{channelOffset( index )};
+        return Accumulator
+        {
+            word( base + Min ),
+            word( base + Max ),
+            static_cast<uint32_t>( word( base + SumHigh ) ) << 16 | word( base + SumLow )
+        };
+    }
+
+    auto alarmed() -> bool
+    {
+        for ( uint8_t index{0}; index < Sampling::channelsCount; ++index )
+        {
+            const auto base{channelOffset( index )};
+            if ( word( base + Min ) < word( base + Threshold ) )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto threshold( uint16_t level, uint32_t current, uint16_t previous ) -> uint16_t
+    {
+        if ( current == unknown )
+        {
+            return previous;
+        }
+        return current >= level ? level : 0;
+    }
+} // namespace Ulp
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+#include <array>
+#include <chrono>
+
+#include "Sampling.hpp"
+
+namespace Ulp
+{
+    // A current reading nobody took yet, see threshold()
+    static constexpr uint32_t unknown{UINT32_MAX};
+
+    // Per channel readings of one batch, in 12 bit ADC counts
+    struct Accumulator
+    {
+        uint16_t min;
+        uint16_t max;
+        uint32_t sum;
+    };
+
+    // Samples the MPX channels every period during deep sleep and wakes the main CPU after batch samples,
+    // or as soon as a channel reads below its threshold, 0 disabling it
+    auto start( const std::array<uint16_t, Sampling::channelsCount>& thresholds, std::chrono::milliseconds period, uint16_t batch ) -> void;
+    // Starts the next batch with the same thresholds, after a batch wake-up
+    auto restart() -> void;
+
+    auto count() -> uint16_t;
+    auto get( uint8_t index ) -> Accumulator;
+    // A threshold crossing rather than a full batch woke the main CPU
+    auto alarmed() -> bool;
+
+    // Threshold of a channel alarming below level, all in 12 bit ADC counts. A channel already below it would wake
+    // straight away and stays quiet until the next day, one without a current reading keeps the previous threshold
+    auto threshold( uint16_t level, uint32_t current, uint16_t previous ) -> uint16_t;
+} // namespace Ulp
@@ -1,63 +1,93 @@
 #include <ctime>
-#include <unordered_map>
+#include <cmath>
+#include <cstdio>
 #include <sstream>
 #include <iomanip>
+#include <array>
+#include <algorithm>
 
 #include "Utils.hpp"
 
 
 namespace Utils
 {
-    static std::unordered_map<void( * )(), std::chrono::system_clock::time_point> timers{};
-    auto periodic( std::chrono::milliseconds interval, void( *func )() ) -> void
+    static auto toChars( char* first, uint64_t value ) -> char*
     {
-        if( interval > std::chrono::milliseconds( 0 ) )
+        auto digits{std::array<char, 20> {}};
+        auto count{size_t{0}};
+        do
         {
-            const auto now{std::chrono::system_clock::now()};
-            auto timer{Utils::timers.find( func )};
-            if( timer != Utils::timers.end() )
-            {
-                if( now >= timer->second )
-                {
-                    func();
-                    timer->second = now + interval;
-                }
-            }
-            else
-            {
-                func();
-                Utils::timers.insert( { func, now + interval } );
-            }
+            digits[count++] = '0' + value % 10;
+            value /= 10;
         }
-        else
+        while ( value > 0 );
+
+        while ( count > 0 )
         {
-            func();
+            *first++ = digits[--count];
         }
+        return first;
     }
 
-    auto bound( std::chrono::milliseconds interval, void( *func )() ) -> void
+    static auto toChars( char* first, uint32_t value, uint8_t width ) -> char*
     {
-        if( interval > std::chrono::milliseconds( 0 ) )
+        for ( auto n{width}; n > 0; --n )
         {
-            const auto now{std::chrono::system_clock::now()};
-            auto timer{Utils::timers.find( func )};
-            if( timer != Utils::timers.end() )
-            {
-                if( now >= timer->second )
-                {
-                    func();
-                    timer->second = now + interval;
-                }
-            }
-            else
-            {
-                Utils::timers.insert( { func, Utils::DateTime::ceil( now, interval ) } );
-            }
+            first[n - 1] = '0' + value % 10;
+            value /= 10;
         }
-        else
+        return first + width;
+    }
+
+    auto toChars( char* first, int64_t value ) -> char*
+    {
+        if ( value < 0 )
         {
-            func();
+            *first++ = '-';
+            return toChars( first, ~static_cast<uint64_t>( value ) + 1 );
         }
+        return toChars( first, static_cast<uint64_t>( value ) );
+    }
+
+    auto toChars( char* first, double value, uint8_t decimals, char decimalPoint ) -> char*
+    {
+        static constexpr std::array<uint32_t, 10> scales{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+        if ( std::isnan( value ) )
+        {
+            *first++ = 'n';
+            *first++ = 'a';
+            *first++ = 'n';
+            return first;
+        }
+        if ( std::isinf( value ) or std::fabs( value ) >= 1e15 )
+        {
+            // Out of the fixed point range, rare enough for the libc path
+            return first + std::sprintf( first, "%.*g", decimals + 1, value );
+        }
+
+        decimals = std::min<uint8_t>( decimals, scales.size() - 1 );
+        const auto scale{scales[decimals]};
+        const auto rounded{static_cast<uint64_t>( std::llround( std::fabs( value ) * scale ) )};
+
+        if ( value < 0 and rounded > 0 )
+        {
+            *first++ = '-';
+        }
+        first = toChars( first, rounded / scale );
+
+        auto fraction{static_cast<uint32_t>( rounded % scale )};
+        if ( fraction > 0 )
+        {
+            while ( fraction % 10 == 0 )
+            {
+                fraction /= 10;
+                decimals--;
+            }
+            *first++ = decimalPoint;
+            first = toChars( first, fraction, decimals );
+        }
+        return first;
     }
 
     namespace DateTime
@@ -78,6 +108,25 @@ namespace Utils
             return stream.str();
         }
 
+        auto toChars( char* first, std::time_t time ) -> char*
+        {
+            auto local{std::tm{}};
+            localtime_r( &time, &local );
+
+            first = Utils::toChars( first, static_cast<uint32_t>( local.tm_year + 1900 ), 4 );
+            *first++ = '-';
+            first = Utils::toChars( first, static_cast<uint32_t>( local.tm_mon + 1 ), 2 );
+            *first++ = '-';
+            first = Utils::toChars( first, static_cast<uint32_t>( local.tm_mday ), 2 );
+            *first++ = ' ';
+            first = Utils::toChars( first, static_cast<uint32_t>( local.tm_hour ), 2 );
+            *first++ = ':';
+            first = Utils::toChars( first, static_cast<uint32_t>( local.tm_min ), 2 );
+            *first++ = ':';
+            first = Utils::toChars( first, static_cast<uint32_t>( local.tm_sec ), 2 );
+            return first;
+        }
+
         auto fromStringHttp( const std::string& str ) -> std::chrono::system_clock::time_point
         {
             auto stream{std::istringstream{str}};
@@ -1,16 +1,21 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
 
 namespace Utils
 {
-    auto periodic( std::chrono::milliseconds interval, void( *func )() ) -> void;
-    auto bound( std::chrono::milliseconds interval, void( *func )() ) -> void;
+    // Allocation free formatters writing at first and returning one past the last written char, like std::to_chars
+    auto toChars( char* first, int64_t value ) -> char*;
+    auto toChars( char* first, double value, uint8_t decimals, char decimalPoint = '.' ) -> char*;
 
     namespace DateTime
     {
         auto fromString( const std::string& str ) -> std::chrono::system_clock::time_point;
         auto toString( const std::chrono::system_clock::time_point& timePoint ) -> std::string;
+        auto toChars( char* first, std::time_t time ) -> char*;
         auto fromStringHttp( const std::string& str ) -> std::chrono::system_clock::time_point;
         auto toStringHttp( const std::chrono::system_clock::time_point& timePoint ) -> std::string;
         auto compiled(const char* compiledDate = __DATE__, const char* compiledTime = __TIME__) -> std::chrono::system_clock::time_point;
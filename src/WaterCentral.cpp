@@ -15,38 +15,74 @@
 #include "Display.hpp"
 #include "Infos.hpp"
 #include "Button.hpp"
+#include "Scheduler.hpp"
+#include "Bus.hpp"
+#include "Indicator.hpp"
+#include "SleepLog.hpp"
+#include "Boot.hpp"
 
 Button button{Peripherals::BTN};
 
 void setup()
 {
-    delay( 1000 );
+    // Overnight timer wake-ups only sample into RTC memory and go back to sleep from here
+    SleepLog::resume();
+
     Serial.begin( 115200 );
     Serial.setDebugOutput( true );
     log_d( "begin" );
 
-    Peripherals::init();
-    Configuration::init();
-    Display::init();
-
-    Configuration::load( &cfg );
+    // Woken at night only to empty the sample buffer: everything runs now, the display and WiFi stay off
+    const auto draining{SleepLog::draining()};
+    const auto later{draining ? Boot::Mode::Now : Boot::Mode::Deferred};
 
-    RealTime::init();
-    Database::init();
-    WebInterface::init();
-    Infos::init();
+    // Up to the first reading runs before setup() returns, the rest follows from the loop
+    Boot::stage( "peripherals", Peripherals::init );
+    Boot::stage( "bus", Bus::init, {"peripherals"} );
+    Boot::stage( "indicator", Indicator::init );
+    Boot::stage( "configuration", []()
+    {
+        Configuration::init();
+        Configuration::load( &cfg );
+    }, {"peripherals"} );
+    Boot::stage( "infos", Infos::init, {"bus", "configuration"} );
+    Boot::stage( "button", []()
+    {
+        button.initInterrupt();
+        button.onPress( Display::ignore );
+        // Edges are timestamped by the interrupt, so polling this seldom loses no presses
+        Scheduler::periodic( std::chrono::milliseconds( 50 ), []()
+        {
+            button.process();
+        } );
+    }, {"indicator"} );
+    if ( not draining )
+    {
+        Boot::stage( "display", Display::init, {"bus", "configuration"}, later );
+    }
+    Boot::stage( "database", Database::init, {"configuration"}, later );
+    // Its sleep alarm flushes the database
+    Boot::stage( "realtime", RealTime::init, {"bus", "database"}, later );
+    Boot::stage( "sleeplog", SleepLog::drain, {"database", "infos"}, later );
+    if ( not draining )
+    {
+        Boot::stage( "network", WebInterface::init, {"database", "infos"}, later );
+    }
+    Boot::run();
 
-    button.onPress( Display::ignore );
+    if ( draining )
+    {
+        RealTime::sleep();
+    }
 
     log_d( "end" );
 }
 
 void loop()
 {
-    Infos::process();
-    Database::process();
-    RealTime::process();
-    WebInterface::process();
-    Display::process();
-    button.process();
+    Scheduler::process();
+
+    // Sleep until the next deadline
+    const auto idle{std::chrono::duration_cast<std::chrono::milliseconds>( Scheduler::untilNext() )};
+    delay( idle.count() );
 }
\ No newline at end of file
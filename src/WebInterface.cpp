@@ -6,51 +6,169 @@
 #include <WiFi.h>
 #include <chrono>
 #include <cstdlib>
+#include <cstdio>
 #include <cstdint>
 #include <esp_log.h>
 #include <functional>
 #include <memory>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 #include <Update.h>
 #include <esp_task_wdt.h>
 #include <soc/rtc_wdt.h>
 #include <rom/rtc.h>
+#include <FastCRC.h>
 
 #include "Configuration.hpp"
+#include "Csv.hpp"
 #include "Database.hpp"
 #include "Peripherals.hpp"
 #include "RealTime.hpp"
 #include "WebInterface.hpp"
 #include "Utils.hpp"
 #include "Infos.hpp"
-
-extern const uint8_t configuration_html_start[] asm( "_binary_html_configuration_html_start" );
-extern const uint8_t configuration_js_start[] asm( "_binary_html_configuration_js_start" );
-extern const uint8_t data_html_start[] asm( "_binary_html_data_html_start" );
-extern const uint8_t data_js_start[] asm( "_binary_html_data_js_start" );
-extern const uint8_t jquery_min_js_start[] asm( "_binary_html_jquery_min_js_start" );
-extern const uint8_t infos_html_start[] asm( "_binary_html_infos_html_start" );
-extern const uint8_t infos_js_start[] asm( "_binary_html_infos_js_start" );
-extern const uint8_t style_css_start[] asm( "_binary_html_style_css_start" );
-
-extern const uint8_t configuration_html_end[] asm( "_binary_html_configuration_html_end" );
-extern const uint8_t configuration_js_end[] asm( "_binary_html_configuration_js_end" );
-extern const uint8_t data_html_end[] asm( "_binary_html_data_html_end" );
-extern const uint8_t data_js_end[] asm( "_binary_html_data_js_end" );
-extern const uint8_t jquery_min_js_end[] asm( "_binary_html_jquery_min_js_end" );
-extern const uint8_t infos_html_end[] asm( "_binary_html_infos_html_end" );
-extern const uint8_t infos_js_end[] asm( "_binary_html_infos_js_end" );
-extern const uint8_t style_css_end[] asm( "_binary_html_style_css_end" );
+#include "Scheduler.hpp"
+#include "Bus.hpp"
+#include "Boot.hpp"
+#include "Sampling.hpp"
+
+extern const uint8_t configuration_html_start[] asm( "_binary_html_configuration_html_gz_start" );
+extern const uint8_t configuration_js_start[] asm( "_binary_html_configuration_js_gz_start" );
+extern const uint8_t data_html_start[] asm( "_binary_html_data_html_gz_start" );
+extern const uint8_t data_js_start[] asm( "_binary_html_data_js_gz_start" );
+extern const uint8_t jquery_min_js_start[] asm( "_binary_html_jquery_min_js_gz_start" );
+extern const uint8_t infos_html_start[] asm( "_binary_html_infos_html_gz_start" );
+extern const uint8_t infos_js_start[] asm( "_binary_html_infos_js_gz_start" );
+extern const uint8_t style_css_start[] asm( "_binary_html_style_css_gz_start" );
+
+extern const uint8_t configuration_html_end[] asm( "_binary_html_configuration_html_gz_end" );
+extern const uint8_t configuration_js_end[] asm( "_binary_html_configuration_js_gz_end" );
+extern const uint8_t data_html_end[] asm( "_binary_html_data_html_gz_end" );
+extern const uint8_t data_js_end[] asm( "_binary_html_data_js_gz_end" );
+extern const uint8_t jquery_min_js_end[] asm( "_binary_html_jquery_min_js_gz_end" );
+extern const uint8_t infos_html_end[] asm( "_binary_html_infos_html_gz_end" );
+extern const uint8_t infos_js_end[] asm( "_binary_html_infos_js_gz_end" );
+extern const uint8_t style_css_end[] asm( "_binary_html_style_css_gz_end" );
 
 namespace WebInterface
 {
     static std::unique_ptr<AsyncWebServer> server{};
+    static AsyncEventSource* events{};
+    // Port the current server listens on, 0 while there is none
+    static uint16_t serverPort{};
+    static bool headersAdded{false};
     static std::chrono::system_clock::time_point modeTimer{};
 
-    static auto buildFilter( AsyncWebServerRequest* request ) -> Database::Filter
+    // AsyncEventSource 1.2.3 keeps its clients in a list without a lock, changed by the AsyncTCP task as they come and
+    // go. The loop task only leaves the payload here, the next poll of a client sends it to all of them from AsyncTCP.
+    static SemaphoreHandle_t eventsLock{};
+    static auto eventsPayload{std::string{}};
+    static bool eventsPending{false};
+    // AsyncTCP polls each connection every 500 ms, a poll seen lately means someone listens
+    static std::atomic<uint32_t> eventsPolled{0};
+    static constexpr uint32_t eventsListening{2000};
+
+    struct Asset
+    {
+        const char* contentType;
+        const uint8_t* start;
+        const uint8_t* end;
+        std::string etag;
+    };
+
+    static Asset configurationHtml{"text/html", configuration_html_start, configuration_html_end};
+    static Asset configurationJs{"application/javascript", configuration_js_start, configuration_js_end};
+    static Asset dataHtml{"text/html", data_html_start, data_html_end};
+    static Asset dataJs{"application/javascript", data_js_start, data_js_end};
+    static Asset jqueryMinJs{"application/javascript", jquery_min_js_start, jquery_min_js_end};
+    static Asset infosHtml{"text/html", infos_html_start, infos_html_end};
+    static Asset infosJs{"application/javascript", infos_js_start, infos_js_end};
+    static Asset styleCss{"text/css", style_css_start, style_css_end};
+
+    static constexpr size_t dataPageSize{20};
+    static constexpr size_t dataPageMaxSize{50};
+
+    // Handlers run on the AsyncTCP task while the loop may be replacing cfg, the snapshot carries the sensor count safely
+    static auto sensorsCount() -> size_t
+    {
+        return Infos::Snapshot::get().count;
+    }
+
+    // JSON document sizes grow with the configured sensors
+    static auto infosJsonCapacity() -> size_t
+    {
+        return 1536 + 128 * sensorsCount();
+    }
+
+    static auto serializeInfos( ArduinoJson::JsonVariant& json ) -> void
+    {
+        Infos::Snapshot::get().serialize( json );
+        {
+            auto storage{ArduinoJson::JsonVariant{json.createNestedObject( "storage" )}};
+            Database::Statistics::get().serialize( storage );
+        }
+        {
+            auto bus{ArduinoJson::JsonVariant{json.createNestedObject( "bus" )}};
+            Bus::Statistics::get().serialize( bus );
+        }
+        {
+            auto boot{ArduinoJson::JsonVariant{json.createNestedObject( "boot" )}};
+            Boot::Statistics::get().serialize( boot );
+        }
+        {
+            // Every internal channel should count up, one stuck at 0 is missing from the SAR1 pattern
+            auto sampling{json.createNestedArray( "conversions" )};
+            for ( uint8_t n{0}; n < Sampling::channelsCount; ++n )
+            {
+                sampling.add( Sampling::conversions( n ) );
+            }
+        }
+    }
+
+    // Serialized once per Infos update, deliverInfos() fans it out to every /events client
+    static auto publishInfos() -> void
+    {
+        static auto payload{std::string{}};
+
+        if ( events == nullptr or millis() - eventsPolled.load() > eventsListening )
+        {
+            return;
+        }
+
+        auto doc{ArduinoJson::DynamicJsonDocument{infosJsonCapacity()}};
+        auto json{doc.as<ArduinoJson::JsonVariant>()};
+        serializeInfos( json );
+
+        payload.clear();
+        ArduinoJson::serializeJson( doc, payload );
+
+        xSemaphoreTake( eventsLock, portMAX_DELAY );
+        eventsPayload.swap( payload );
+        eventsPending = true;
+        xSemaphoreGive( eventsLock );
+    }
+
+    // Runs on the AsyncTCP task from the poll of any /events client, where the library changes its client list
+    static auto deliverInfos() -> void
+    {
+        eventsPolled = millis();
+
+        xSemaphoreTake( eventsLock, portMAX_DELAY );
+        if ( eventsPending and events != nullptr )
+        {
+            events->send( eventsPayload.data(), "infos" );
+            eventsPending = false;
+        }
+        xSemaphoreGive( eventsLock );
+    }
+
+    static auto buildFilter( AsyncWebServerRequest* request, size_t limit = 0 ) -> Database::Filter
     {
         auto id{int64_t{}};
         auto start{std::chrono::system_clock::time_point::min()};
         auto end{std::chrono::system_clock::time_point::max()};
+        auto after{Database::Cursor{}};
 
         if ( request->hasParam( "id" ) )
         {
@@ -64,35 +182,53 @@ namespace WebInterface
         {
             end = Utils::DateTime::fromString( request->getParam( "end" )->value().c_str() );
         }
+        if ( request->hasParam( "cursor" ) )
+        {
+            after = Database::Cursor::fromString( request->getParam( "cursor" )->value().c_str() );
+        }
 
-        return Database::Filter{id, start, end};
+        return Database::Filter{id, start, end, after, limit};
     }
 
     namespace Get
     {
-        static auto handleProgmem( AsyncWebServerRequest* request, const std::string& contentType, const uint8_t* content, size_t len ) -> void
+        // Assets are embedded gzipped, the strong ETag is the CRC32 of the compressed content
+        static auto handleAsset( AsyncWebServerRequest* request, Asset& asset ) -> void
         {
-            const auto lastModified{Utils::DateTime::compiled()};
-            auto ifModifiedSince{std::chrono::system_clock::time_point::min()};
-
-            if ( request->hasHeader( "If-Modified-Since" ) )
+            if ( asset.etag.empty() )
             {
-                ifModifiedSince = Utils::DateTime::fromStringHttp( request->getHeader( "If-Modified-Since" )->value().c_str() );
+                static constexpr size_t chunk{0x8000};
+
+                auto crc32{FastCRC32{}};
+                auto crc{crc32.crc32( asset.start, std::min<size_t>( asset.end - asset.start, chunk ) )};
+                for ( auto position{asset.start + chunk}; position < asset.end; position += chunk )
+                {
+                    crc = crc32.crc32_upd( position, std::min<size_t>( asset.end - position, chunk ) );
+                }
+
+                auto etag{std::array<char, 11> {}};
+                std::snprintf( etag.data(), etag.size(), "\"%08x\"", static_cast<unsigned>( crc ) );
+                asset.etag = etag.data();
             }
 
-            auto response{lastModified <= ifModifiedSince ? request->beginResponse( 304 ) : request->beginResponse_P( 200, contentType.data(), content, len )};
-            response->addHeader( "Last-Modified", Utils::DateTime::toStringHttp( lastModified ).data() );
-            response->addHeader( "Date", Utils::DateTime::toStringHttp( std::chrono::system_clock::now() ).data() );
-            response->addHeader( "Cache-Control", "public, max-age=0" );
+            const auto notModified{request->hasHeader( "If-None-Match" ) and std::strstr( request->getHeader( "If-None-Match" )->value().c_str(), asset.etag.data() ) != nullptr};
+
+            auto response{notModified ? request->beginResponse( 304 ) : request->beginResponse_P( 200, asset.contentType, asset.start, static_cast<size_t>( asset.end - asset.start ) )};
+            if ( not notModified )
+            {
+                response->addHeader( "Content-Encoding", "gzip" );
+            }
+            response->addHeader( "ETag", asset.etag.data() );
+            response->addHeader( "Cache-Control", "no-cache" );
             request->send( response );
         }
 
         static auto handleConfigurationJson( AsyncWebServerRequest* request ) -> void
         {
-            auto response{new AsyncJsonResponse{false, 2048}};
+            auto response{new AsyncJsonResponse{false, Configuration::jsonCapacity}};
             auto& responseJson{response->getRoot()};
 
-            cfg.serialize( responseJson );
+            Configuration::get().serialize( responseJson );
 
             response->setLength();
             request->send( response );
@@ -100,16 +236,31 @@ namespace WebInterface
 
         static auto handleDataJson( AsyncWebServerRequest* request ) -> void
         {
-            auto response{new AsyncJsonResponse{true, 4096}};
+            auto limit{dataPageSize};
+            if ( request->hasParam( "limit" ) )
+            {
+                limit = constrain( static_cast<size_t>( request->getParam( "limit" )->value().toInt() ), size_t{1}, dataPageMaxSize );
+            }
+
+            auto response{new AsyncJsonResponse{false, 256 + ( 256 + 16 * sensorsCount() ) * limit}};
             auto& responseJson{response->getRoot()};
 
             {
-                auto filter{ WebInterface::buildFilter( request )};
+                auto data{ArduinoJson::JsonVariant{responseJson.createNestedArray( "data" )}};
+                auto last{Database::Cursor{}};
+
+                auto filter{ WebInterface::buildFilter( request, limit )};
                 Database::SensorData sensorData;
-                for ( auto n{0}; n < 20 and filter.next( &sensorData ); ++n )
+                while ( filter.next( &sensorData ) )
                 {
-                    auto element{responseJson.addElement()};
+                    auto element{data.addElement()};
                     sensorData.serialize( element );
+                    last = Database::Cursor{sensorData.dateTime, sensorData.id};
+                }
+
+                if ( last )
+                {
+                    responseJson["cursor"] = last.toString();
                 }
             }
 
@@ -130,10 +281,10 @@ namespace WebInterface
 
         static auto handleInfosJson( AsyncWebServerRequest* request ) -> void
         {
-            auto response{new AsyncJsonResponse{}};
+            auto response{new AsyncJsonResponse{false, infosJsonCapacity()}};
             auto& responseJson{response->getRoot()};
 
-            Infos::serialize( responseJson );
+            serializeInfos( responseJson );
 
             response->setLength();
             request->send( response );
@@ -141,105 +292,144 @@ namespace WebInterface
 
         static auto handleConfigurationHtml( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "text/html", configuration_html_start, static_cast<size_t>( configuration_html_end - configuration_html_start ) );
-            request->send_P( 200, "text/html", configuration_html_start, static_cast<size_t>( configuration_html_end - configuration_html_start ) );
+            handleAsset( request, configurationHtml );
         }
 
         static auto handleConfigurationJs( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "application/javascript", configuration_js_start, static_cast<size_t>( configuration_js_end - configuration_js_start ) );
-            request->send_P( 200, "application/javascript", configuration_js_start, static_cast<size_t>( configuration_js_end - configuration_js_start ) );
+            handleAsset( request, configurationJs );
         }
 
         static auto handleDataHtml( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "text/html", data_html_start, static_cast<size_t>( data_html_end - data_html_start ) );
-            request->send_P( 200, "text/html", data_html_start, static_cast<size_t>( data_html_end - data_html_start ) );
+            handleAsset( request, dataHtml );
         }
 
         static auto handleDataJs( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "application/javascript", data_js_start, static_cast<size_t>( data_js_end - data_js_start ) );
-            request->send_P( 200, "application/javascript", data_js_start, static_cast<size_t>( data_js_end - data_js_start ) );
+            handleAsset( request, dataJs );
         }
 
-        class comma_punct : public std::numpunct<char>
+        static constexpr size_t csvRowMaxLen{Csv::rowMaxLen( Configuration::maxSensors )};
+
+        struct CsvExport
         {
-            protected:
-                char do_decimal_point() const override
-                {
-                    return ',';   //comma
-                }
+            Database::Filter filter;
+            Database::SensorData sensorData;
+            Csv::Chunks<csvRowMaxLen> chunks;
         };
-        std::locale loc{ std::locale{}, new comma_punct };
 
         static auto handleDataCsv( AsyncWebServerRequest* request ) -> void
         {
-            auto stream{std::make_shared<std::stringstream>()};
-            stream->imbue( loc );
-            auto filter{std::make_shared<Database::Filter>( WebInterface::buildFilter( request ) )};
+            auto csv{std::make_shared<CsvExport>( CsvExport{WebInterface::buildFilter( request ), {}, {}} )};
+            csv->chunks.begin( []( char* first )
+            {
+                return Csv::header( first, std::min( sensorsCount(), size_t{Configuration::maxSensors} ) );
+            } );
+
             auto response{request->beginChunkedResponse( "text/csv", [ = ]( uint8_t* buffer, size_t maxLen, size_t index ) -> size_t {
-                    auto len{stream->readsome( reinterpret_cast<char*>( buffer ), maxLen )};
-                    if ( len == 0 )
+                    const auto first{reinterpret_cast<char*>( buffer )};
+                    const auto last{csv->chunks.fill( first, first + maxLen, [&csv]( char* first ) -> char*
                     {
-                        if( index == 0 )
+                        auto& sensorData{csv->sensorData};
+                        if ( not csv->filter.next( &sensorData ) )
                         {
-                            ( *stream ) << "id" << ';'
-                                        << "datetime" << ';'
-                                        << "temperature" << ';'
-                                        << "humidity" << ';'
-                                        << "pressure" << ';'
-                                        << "sensor_0" << ';'
-                                        << "sensor_1" << ';'
-                                        << "sensor_2" << "\r\n";
-                            len = stream->readsome( reinterpret_cast<char*>( buffer ), maxLen );
+                            return nullptr;
                         }
-                        else
+                        return Csv::row( first, sensorData.id, sensorData.dateTime, sensorData.temperature, sensorData.humidity, sensorData.pressure,
+                                         sensorData.sensors.data(), std::min( sensorData.sensors.size(), size_t{Configuration::maxSensors} ) );
+                    } )};
+                    return last - first;
+                } )};
+            response->addHeader( "Content-Disposition", "attachment;filename=data.csv" );
+            request->send( response );
+            log_d( "end" );
+        }
+
+        static auto handleSummaryJson( AsyncWebServerRequest* request ) -> void
+        {
+            auto end{std::chrono::system_clock::now()};
+            auto start{end - std::chrono::hours( 24 )};
+            auto points{size_t{400}};
+
+            if ( request->hasParam( "start" ) )
+            {
+                start = Utils::DateTime::fromString( request->getParam( "start" )->value().c_str() );
+            }
+            if ( request->hasParam( "end" ) )
+            {
+                end = Utils::DateTime::fromString( request->getParam( "end" )->value().c_str() );
+            }
+            if ( request->hasParam( "points" ) )
+            {
+                points = constrain( static_cast<size_t>( request->getParam( "points" )->value().toInt() ), size_t{1}, size_t{1000} );
+            }
+
+            static constexpr std::array<const char*, 3> resolutions{"raw", "hourly", "daily"};
+
+            auto summary{std::make_shared<Database::Summary>( start, end, points )};
+            auto pending{std::make_shared<std::string>( std::string{"{\"resolution\":\""} + resolutions[summary->getResolution()] + "\",\"data\":[" )};
+            auto count{std::make_shared<size_t>( 0 )};
+            auto finished{std::make_shared<bool>( false )};
+            auto response{request->beginChunkedResponse( "application/json", [ = ]( uint8_t* buffer, size_t maxLen, size_t index ) -> size_t {
+                    auto len{size_t{0}};
+                    while ( len < maxLen )
+                    {
+                        if ( pending->empty() )
                         {
-                            Database::SensorData sensorData;
-                            if( filter->next( &sensorData ) )
+                            if ( *finished )
+                            {
+                                break;
+                            }
+
+                            Database::SummaryData summaryData;
+                            if ( summary->next( &summaryData ) )
+                            {
+                                auto doc{ArduinoJson::DynamicJsonDocument{512 + 96 * summaryData.sensors.size()}};
+                                auto json{doc.as<ArduinoJson::JsonVariant>()};
+                                summaryData.serialize( json );
+
+                                if ( ( *count )++ > 0 )
+                                {
+                                    pending->push_back( ',' );
+                                }
+                                ArduinoJson::serializeJson( doc, *pending );
+                            }
+                            else
                             {
-                                ( *stream ) << sensorData.id << ';'
-                                            << Utils::DateTime::toString( std::chrono::system_clock::from_time_t( sensorData.dateTime ) ) << ';'
-                                            << sensorData.temperature << ';'
-                                            << sensorData.humidity << ';'
-                                            << sensorData.pressure << ';'
-                                            << sensorData.sensors[0] << ';'
-                                            << sensorData.sensors[1] << ';'
-                                            << sensorData.sensors[2] << "\r\n";
-                                len = stream->readsome( reinterpret_cast<char*>( buffer ), maxLen );
+                                pending->append( "]}" );
+                                *finished = true;
                             }
                         }
+
+                        const auto chunk{std::min( pending->size(), maxLen - len )};
+                        std::memcpy( buffer + len, pending->data(), chunk );
+                        pending->erase( 0, chunk );
+                        len += chunk;
                     }
                     return len;
                 } )};
-            response->addHeader( "Content-Disposition", "attachment;filename=data.csv" );
             request->send( response );
-            log_d( "end" );
         }
 
         static auto handleJqueryJs( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "application/javascript", jquery_min_js_start, static_cast<size_t>( jquery_min_js_end - jquery_min_js_start ) );
-            request->send_P( 200, "application/javascript", jquery_min_js_start, static_cast<size_t>( jquery_min_js_end - jquery_min_js_start ) );
+            handleAsset( request, jqueryMinJs );
         }
 
         static auto handleInfosHtml( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "text/html", infos_html_start, static_cast<size_t>( infos_html_end - infos_html_start ) );
-            request->send_P( 200, "text/html", infos_html_start, static_cast<size_t>( infos_html_end - infos_html_start ) );
+            handleAsset( request, infosHtml );
         }
 
         static auto handleInfosJs( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "application/javascript", infos_js_start, static_cast<size_t>( infos_js_end - infos_js_start ) );
-            request->send_P( 200, "application/javascript", infos_js_start, static_cast<size_t>( infos_js_end - infos_js_start ) );
+            handleAsset( request, infosJs );
         }
 
         static auto handleStyleCss( AsyncWebServerRequest* request ) -> void
         {
-            //handleProgmem( request, "text/css", style_css_start, static_cast<size_t>( style_css_end - style_css_start ) );
-            request->send_P( 200, "text/css", style_css_start, static_cast<size_t>( style_css_end - style_css_start ) );
+            handleAsset( request, styleCss );
         }
 
     } // namespace Get
@@ -251,16 +441,18 @@ namespace WebInterface
             auto response{new AsyncJsonResponse{}};
             auto& responseJson{response->getRoot()};
 
-            auto newCfg{cfg};
-            newCfg.deserialize( requestJson );
-            Configuration::save( newCfg );
-
-            responseJson.set( "Configuration saved, restarting in 3 seconds" );
+            // Saved here, then applied from the loop, which only restarts when a module cannot follow the change
+            if ( Configuration::request( requestJson ) )
+            {
+                responseJson.set( "Configuration saved, applying" );
+            }
+            else
+            {
+                response->setCode( 500 );
+                responseJson.set( "Configuration not saved" );
+            }
             response->setLength();
             request->send( response );
-
-            delay( 3000 );
-            esp_restart();
         }
 
         static auto handleDateTimeJson( AsyncWebServerRequest* request, JsonVariant& requestJson ) -> void
@@ -271,12 +463,9 @@ namespace WebInterface
             const auto dateTime{Utils::DateTime::fromString( requestJson.as<std::string>() )};
             RealTime::adjustDateTime( dateTime );
 
-            responseJson.set( "DateTime saved, restarting in 3 seconds" );
+            responseJson.set( "DateTime saved" );
             response->setLength();
             request->send( response );
-
-            delay( 3000 );
-            ESP.restart();
         }
 
         static auto handleUpdate( AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final ) -> void
@@ -314,6 +503,7 @@ namespace WebInterface
                     return;
                 }
                 request->send( 200, "text/plain", "Success, rebooting in 3 seconds" );
+                Database::flush();
                 delay( 3000 );
                 ESP.restart();
             }
@@ -322,23 +512,44 @@ namespace WebInterface
 
     static auto configureServer() -> void
     {
-        server.release();
-
-        if ( WiFi.getMode() == WIFI_MODE_STA )
+        const auto mode{WiFi.getMode()};
+        auto port{uint16_t{0}};
+        if ( mode == WIFI_MODE_STA )
         {
-            server.reset( new AsyncWebServer{cfg.station.port} );
+            port = cfg.station.port;
         }
-        else if ( WiFi.getMode() == WIFI_MODE_AP )
+        else if ( mode == WIFI_MODE_AP )
         {
-            server.reset( new AsyncWebServer{cfg.accessPoint.port} );
+            port = cfg.accessPoint.port;
         }
 
+        // The listener is bound to every interface, so clients keep their connections unless the port changes
+        if ( server and port == serverPort )
+        {
+            return;
+        }
+
+        // The server owns its handlers, events included, so it must stop listening and serving before it is freed
         if ( server )
         {
+            xSemaphoreTake( eventsLock, portMAX_DELAY );
+            events->close();
+            server->end();
+            server.reset();
+            events = nullptr;
+            xSemaphoreGive( eventsLock );
+        }
+        serverPort = port;
+
+        if ( port != 0 )
+        {
+            server.reset( new AsyncWebServer{port} );
+
             server->on( "/configuration.json", HTTP_GET, Get::handleConfigurationJson );
             server->on( "/datetime.json", HTTP_GET, Get::handleDateTimeJson );
             server->on( "/data.json", HTTP_GET, Get::handleDataJson );
             server->on( "/infos.json", HTTP_GET, Get::handleInfosJson );
+            server->on( "/summary.json", HTTP_GET, Get::handleSummaryJson );
             server->on( "/configuration.html", HTTP_GET, Get::handleConfigurationHtml );
             server->on( "/configuration.js", HTTP_GET, Get::handleConfigurationJs );
             server->on( "/data.html", HTTP_GET, Get::handleDataHtml );
@@ -349,14 +560,30 @@ namespace WebInterface
             server->on( "/infos.js", HTTP_GET, Get::handleInfosJs );
             server->on( "/style.css", HTTP_GET, Get::handleStyleCss );
 
-            server->addHandler( new AsyncCallbackJsonWebHandler( "/configuration.json", Post::handleConfigurationJson, 2048 ) );
+            events = new AsyncEventSource{"/events"};
+            // Chained in front of the poll handler of the library, which still runs its message queue
+            events->onConnect( []( AsyncEventSourceClient * client )
+            {
+                client->client()->onPoll( []( void* arg, AsyncClient* )
+                {
+                    deliverInfos();
+                    static_cast<AsyncEventSourceClient*>( arg )->_onPoll();
+                }, client );
+            } );
+            server->addHandler( events );
+            server->addHandler( new AsyncCallbackJsonWebHandler( "/configuration.json", Post::handleConfigurationJson, Configuration::jsonCapacity ) );
             server->addHandler( new AsyncCallbackJsonWebHandler( "/datetime.json", Post::handleDateTimeJson, 1024 ) );
             server->onFileUpload( Post::handleUpdate );
 
-            DefaultHeaders::Instance().addHeader( "Access-Control-Allow-Origin", "*" );
-            DefaultHeaders::Instance().addHeader( "Access-Control-Allow-Methods", "POST, GET, OPTIONS" );
-            DefaultHeaders::Instance().addHeader( "Access-Control-Allow-Headers", "Content-Type" );
-            DefaultHeaders::Instance().addHeader( "Access-Control-Max-Age", "86400" );
+            // Global to the library, added once however many times the server is rebuilt
+            if ( not headersAdded )
+            {
+                DefaultHeaders::Instance().addHeader( "Access-Control-Allow-Origin", "*" );
+                DefaultHeaders::Instance().addHeader( "Access-Control-Allow-Methods", "POST, GET, OPTIONS" );
+                DefaultHeaders::Instance().addHeader( "Access-Control-Allow-Headers", "Content-Type" );
+                DefaultHeaders::Instance().addHeader( "Access-Control-Max-Age", "86400" );
+                headersAdded = true;
+            }
             server->onNotFound( []( AsyncWebServerRequest * request )
             {
                 if ( request->method() == HTTP_OPTIONS )
@@ -465,21 +692,7 @@ namespace WebInterface
         return true;
     }
 
-    auto init() -> void
-    {
-        log_d( "begin" );
-
-        if( not configureAccessPoint() )
-        {
-            configureStation();
-        }
-
-        modeTimer = std::chrono::system_clock::now();
-
-        log_d( "end" );
-    }
-
-    auto process() -> void
+    static auto checkMode() -> void
     {
         if( cfg.accessPoint.enabled and WiFi.getMode() == WIFI_MODE_AP )
         {
@@ -497,4 +710,44 @@ namespace WebInterface
             }
         }
     }
+
+    template<typename Network>
+    static auto sameNetwork( const Network& a, const Network& b ) -> bool
+    {
+        return a.enabled == b.enabled and a.ip == b.ip and a.netmask == b.netmask and a.gateway == b.gateway and a.port == b.port and a.user == b.user and a.password == b.password;
+    }
+
+    // WiFi and the server are only brought up again when their own fields change, the access point duration is read by checkMode()
+    static auto reconfigure( const Configuration& previous ) -> bool
+    {
+        if ( sameNetwork( cfg.station, previous.station ) and sameNetwork( cfg.accessPoint, previous.accessPoint ) )
+        {
+            return true;
+        }
+
+        if( not configureAccessPoint() )
+        {
+            configureStation();
+        }
+        modeTimer = std::chrono::system_clock::now();
+        return true;
+    }
+
+    auto init() -> void
+    {
+        log_d( "begin" );
+
+        eventsLock = xSemaphoreCreateMutex();
+        if( not configureAccessPoint() )
+        {
+            configureStation();
+        }
+
+        modeTimer = std::chrono::system_clock::now();
+        Infos::onUpdate( WebInterface::publishInfos );
+        Configuration::onChange( WebInterface::reconfigure );
+        Scheduler::periodic( std::chrono::seconds( 1 ), WebInterface::checkMode );
+
+        log_d( "end" );
+    }
 } // namespace WebInterface
\ No newline at end of file
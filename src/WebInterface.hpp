@@ -5,5 +5,4 @@
 namespace WebInterface
 {
     auto init() -> void;
-    auto process() -> void;
 } // namespace WebInterface
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+// Host build: the few Arduino core calls the tested modules make, with pins and time driven by the tests
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#include "Print.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define IRAM_ATTR
+
+static constexpr uint8_t LOW{0x0};
+static constexpr uint8_t HIGH{0x1};
+static constexpr uint8_t INPUT{0x01};
+static constexpr uint8_t INPUT_PULLUP{0x05};
+static constexpr uint8_t OUTPUT{0x02};
+static constexpr int CHANGE{0x03};
+
+namespace Host
+{
+    struct Interrupt
+    {
+        void( *handler )( void* );
+        void* arg;
+    };
+
+    inline auto pins() -> std::array<uint8_t, 40>&
+    {
+        static std::array<uint8_t, 40> levels{};
+        return levels;
+    }
+
+    inline auto interrupts() -> std::array<Interrupt, 40>&
+    {
+        static std::array<Interrupt, 40> handlers{};
+        return handlers;
+    }
+
+    // Sets the level of pin and runs its interrupt handler when the level changed, like the GPIO peripheral would
+    inline auto drive( uint8_t pin, uint8_t level ) -> void
+    {
+        const auto changed{pins()[pin] != level};
+        pins()[pin] = level;
+        if ( changed and interrupts()[pin].handler != nullptr )
+        {
+            interrupts()[pin].handler( interrupts()[pin].arg );
+        }
+    }
+} // namespace Host
+
+inline auto millis() -> unsigned long
+{
+    return static_cast<unsigned long>( esp_timer_get_time() / 1000 );
+}
+
+inline auto micros() -> unsigned long
+{
+    return static_cast<unsigned long>( esp_timer_get_time() );
+}
+
+inline auto delay( uint32_t ms ) -> void
+{
+    Host::advance( int64_t{ms} * 1000 );
+}
+
+inline auto pinMode( uint8_t, uint8_t ) -> void
+{
+}
+
+inline auto digitalRead( uint8_t pin ) -> int
+{
+    return Host::pins()[pin];
+}
+
+inline auto digitalWrite( uint8_t pin, uint8_t level ) -> void
+{
+    Host::pins()[pin] = level;
+}
+
+inline auto attachInterruptArg( uint8_t pin, void( *handler )( void* ), void* arg, int ) -> void
+{
+    Host::interrupts()[pin] = Host::Interrupt{handler, arg};
+}
+
+inline auto detachInterrupt( uint8_t pin ) -> void
+{
+    Host::interrupts()[pin] = Host::Interrupt{};
+}
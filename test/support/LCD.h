@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <cstdint>
+
+// Host build: the LCD base class of NewLiquidCrystal, every command and character goes through send() as on the
+// real library, which is where a test double counts the bytes a display would receive
+
+#define COMMAND 0
+#define DATA 1
+
+#define LCD_CLEARDISPLAY 0x01
+#define LCD_RETURNHOME 0x02
+#define LCD_SETCGRAMADDR 0x40
+#define LCD_SETDDRAMADDR 0x80
+
+#define LCD_1LINE 0x00
+#define LCD_2LINE 0x08
+#define LCD_5x8DOTS 0x00
+
+class LCD : public Print
+{
+    public:
+        LCD() = default;
+
+        virtual void begin( uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS )
+        {
+            this->_cols = cols;
+            this->_numlines = rows;
+        }
+
+        void clear()
+        {
+            this->command( LCD_CLEARDISPLAY );
+        }
+
+        void home()
+        {
+            this->command( LCD_RETURNHOME );
+        }
+
+        void createChar( uint8_t location, uint8_t charmap[] )
+        {
+            this->command( LCD_SETCGRAMADDR | ( location & 0x7 ) << 3 );
+            for ( uint8_t n{0}; n < 8; ++n )
+            {
+                this->write( charmap[n] );
+            }
+        }
+
+        void setCursor( uint8_t col, uint8_t row )
+        {
+            static constexpr uint8_t offsets[]{0x00, 0x40, 0x14, 0x54};
+            static constexpr uint8_t offsetsLarge[]{0x00, 0x40, 0x10, 0x50};
+
+            row = std::min<uint8_t>( row, this->_numlines - 1 );
+            this->command( LCD_SETDDRAMADDR | ( col + ( this->_cols == 16 and this->_numlines == 4 ? offsetsLarge[row] : offsets[row] ) ) );
+        }
+
+        size_t write( uint8_t value ) override
+        {
+            this->send( value, DATA );
+            return 1;
+        }
+        using Print::write;
+
+        virtual void send( uint8_t value, uint8_t mode ) = 0;
+
+    protected:
+        void command( uint8_t value )
+        {
+            this->send( value, COMMAND );
+        }
+
+        uint8_t _displayfunction{};
+        uint8_t _numlines{};
+        uint8_t _cols{};
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Host build: the part of the Arduino Print class the display code prints with
+
+class Print
+{
+    public:
+        virtual ~Print() = default;
+
+        virtual auto write( uint8_t value ) -> size_t = 0;
+
+        auto write( const uint8_t* buffer, size_t size ) -> size_t
+        {
+            auto written{size_t{0}};
+            for ( size_t n{0}; n < size; ++n )
+            {
+                written += this->write( buffer[n] );
+            }
+            return written;
+        }
+
+        auto print( const char* text ) -> size_t
+        {
+            return this->write( reinterpret_cast<const uint8_t*>( text ), std::strlen( text ) );
+        }
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "../esp_err.h"
+
+// Host build: the configuration calls are accepted, conversions read the levels a test puts in Host::adc()
+
+enum adc1_channel_t
+{
+    ADC1_CHANNEL_0,
+    ADC1_CHANNEL_1,
+    ADC1_CHANNEL_2,
+    ADC1_CHANNEL_3,
+    ADC1_CHANNEL_4,
+    ADC1_CHANNEL_5,
+    ADC1_CHANNEL_6,
+    ADC1_CHANNEL_7,
+    ADC1_CHANNEL_MAX
+};
+
+enum adc_bits_width_t
+{
+    ADC_WIDTH_BIT_9,
+    ADC_WIDTH_BIT_10,
+    ADC_WIDTH_BIT_11,
+    ADC_WIDTH_BIT_12
+};
+
+enum adc_atten_t
+{
+    ADC_ATTEN_DB_0,
+    ADC_ATTEN_DB_2_5,
+    ADC_ATTEN_DB_6,
+    ADC_ATTEN_DB_11
+};
+
+namespace Host
+{
+    inline auto adc() -> std::array<uint16_t, ADC1_CHANNEL_MAX>&
+    {
+        static std::array<uint16_t, ADC1_CHANNEL_MAX> counts{};
+        return counts;
+    }
+} // namespace Host
+
+inline auto adc1_config_width( adc_bits_width_t ) -> esp_err_t
+{
+    return ESP_OK;
+}
+
+inline auto adc1_config_channel_atten( adc1_channel_t, adc_atten_t ) -> esp_err_t
+{
+    return ESP_OK;
+}
+
+inline auto adc1_get_raw( adc1_channel_t channel ) -> int
+{
+    return Host::adc()[channel];
+}
+
+inline auto adc1_ulp_enable() -> void
+{
+}
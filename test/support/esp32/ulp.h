@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "../driver/adc.h"
+#include "../esp_err.h"
+
+// Host build: an emulator of the ULP instructions the firmware uses. Macros build a decoded instruction instead of
+// the machine word, Host::ulpTick() runs the loaded program for one period of the ULP timer.
+//
+// Modelled like the ESP32 ULP FSM: 16 bit registers, ALU operations set the overflow flag on a carry out of an add
+// or a borrow of a subtraction and clear it on a move, loads and stores leave it alone. A store writes the value to
+// the lower half word and the address of the store instruction to the upper one.
+
+enum
+{
+    R0,
+    R1,
+    R2,
+    R3
+};
+
+struct ulp_insn_t
+{
+    enum class Op : uint8_t
+    {
+        Adc,
+        Ld,
+        St,
+        AddR,
+        SubR,
+        AddI,
+        MovI,
+        Label,
+        Bx,
+        Bxf,
+        Wake,
+        End,
+        Halt
+    };
+
+    Op op;
+    // Destination, or value register of a store
+    uint8_t reg;
+    // First source, or address register of a load or store
+    uint8_t src1;
+    uint8_t src2;
+    // Offset, immediate, ADC channel or label
+    uint16_t arg;
+};
+
+#define I_ADC( reg_dest, adc_idx, pad_idx ) ulp_insn_t{ ulp_insn_t::Op::Adc, reg_dest, adc_idx, 0, static_cast<uint16_t>( pad_idx ) }
+#define I_LD( reg_dest, reg_addr, offset_ ) ulp_insn_t{ ulp_insn_t::Op::Ld, reg_dest, reg_addr, 0, static_cast<uint16_t>( offset_ ) }
+#define I_ST( reg_val, reg_addr, offset_ ) ulp_insn_t{ ulp_insn_t::Op::St, reg_val, reg_addr, 0, static_cast<uint16_t>( offset_ ) }
+#define I_ADDR( reg_dest, reg_src1, reg_src2 ) ulp_insn_t{ ulp_insn_t::Op::AddR, reg_dest, reg_src1, reg_src2, 0 }
+#define I_SUBR( reg_dest, reg_src1, reg_src2 ) ulp_insn_t{ ulp_insn_t::Op::SubR, reg_dest, reg_src1, reg_src2, 0 }
+#define I_ADDI( reg_dest, reg_src, imm_ ) ulp_insn_t{ ulp_insn_t::Op::AddI, reg_dest, reg_src, 0, static_cast<uint16_t>( imm_ ) }
+#define I_MOVI( reg_dest, imm_ ) ulp_insn_t{ ulp_insn_t::Op::MovI, reg_dest, 0, 0, static_cast<uint16_t>( imm_ ) }
+#define M_LABEL( label_num ) ulp_insn_t{ ulp_insn_t::Op::Label, 0, 0, 0, static_cast<uint16_t>( label_num ) }
+#define M_BX( label_num ) ulp_insn_t{ ulp_insn_t::Op::Bx, 0, 0, 0, static_cast<uint16_t>( label_num ) }
+#define M_BXF( label_num ) ulp_insn_t{ ulp_insn_t::Op::Bxf, 0, 0, 0, static_cast<uint16_t>( label_num ) }
+#define I_WAKE() ulp_insn_t{ ulp_insn_t::Op::Wake, 0, 0, 0, 0 }
+#define I_END() ulp_insn_t{ ulp_insn_t::Op::End, 0, 0, 0, 0 }
+#define I_HALT() ulp_insn_t{ ulp_insn_t::Op::Halt, 0, 0, 0, 0 }
+
+namespace Host
+{
+    struct Ulp
+    {
+        // Labels resolved, branches hold the index of their target
+        std::vector<ulp_insn_t> program;
+        uint32_t loadAddress;
+        uint32_t entryPoint;
+        uint32_t period;
+        bool timer;
+        uint32_t wakes;
+    };
+
+    inline auto ulp() -> Ulp&
+    {
+        static Ulp state{};
+        return state;
+    }
+
+    // The 8 KB of RTC slow memory, in words
+    inline auto rtcSlowMemory() -> std::array<uint32_t, 2048>&
+    {
+        static std::array<uint32_t, 2048> words{};
+        return words;
+    }
+
+    // Runs the program from its entry point to the next halt if the ULP timer is on, false when it is off.
+    // A program still running after maxSteps instructions never halts and fails the run.
+    inline auto ulpTick( uint32_t maxSteps = 10000 ) -> bool
+    {
+        auto& state{ulp()};
+        if ( not state.timer )
+        {
+            return false;
+        }
+
+        auto& memory{rtcSlowMemory()};
+        auto registers{std::array<uint16_t, 4> {}};
+        auto overflow{false};
+        auto pc{static_cast<size_t>( state.entryPoint - state.loadAddress )};
+        const auto alu{[&]( uint8_t reg, uint32_t result, bool carry )
+        {
+            registers[reg] = static_cast<uint16_t>( result );
+            overflow = carry;
+        }};
+
+        for ( uint32_t step{0}; step < maxSteps and pc < state.program.size(); ++step )
+        {
+            const auto& insn{state.program[pc++]};
+            switch ( insn.op )
+            {
+                case ulp_insn_t::Op::Adc:
+                    registers[insn.reg] = adc()[insn.arg] & 0x0FFF;
+                    break;
+                case ulp_insn_t::Op::Ld:
+                    registers[insn.reg] = memory[registers[insn.src1] + insn.arg] & 0xFFFF;
+                    break;
+                case ulp_insn_t::Op::St:
+                    memory[registers[insn.src1] + insn.arg] = ( state.loadAddress + pc - 1 ) << 16 | registers[insn.reg];
+                    break;
+                case ulp_insn_t::Op::AddR:
+                    alu( insn.reg, uint32_t{registers[insn.src1]} + registers[insn.src2], uint32_t{registers[insn.src1]} + registers[insn.src2] > 0xFFFF );
+                    break;
+                case ulp_insn_t::Op::SubR:
+                    alu( insn.reg, uint32_t{registers[insn.src1]} - registers[insn.src2], registers[insn.src1] < registers[insn.src2] );
+                    break;
+                case ulp_insn_t::Op::AddI:
+                    alu( insn.reg, uint32_t{registers[insn.src1]} + insn.arg, uint32_t{registers[insn.src1]} + insn.arg > 0xFFFF );
+                    break;
+                case ulp_insn_t::Op::MovI:
+                    alu( insn.reg, insn.arg, false );
+                    break;
+                case ulp_insn_t::Op::Bx:
+                    pc = insn.arg;
+                    break;
+                case ulp_insn_t::Op::Bxf:
+                    pc = overflow ? insn.arg : pc;
+                    break;
+                case ulp_insn_t::Op::Wake:
+                    state.wakes++;
+                    break;
+                case ulp_insn_t::Op::End:
+                    state.timer = false;
+                    break;
+                case ulp_insn_t::Op::Halt:
+                    return true;
+                case ulp_insn_t::Op::Label:
+                    break;
+            }
+        }
+        std::abort();
+    }
+} // namespace Host
+
+#define RTC_SLOW_MEM ( Host::rtcSlowMemory().data() )
+
+inline auto ulp_process_macros_and_load( uint32_t load_addr, const ulp_insn_t* program, size_t* psize ) -> esp_err_t
+{
+    auto labels{std::map<uint16_t, uint16_t> {}};
+    auto resolved{std::vector<ulp_insn_t> {}};
+    for ( size_t n{0}; n < *psize; ++n )
+    {
+        if ( program[n].op == ulp_insn_t::Op::Label )
+        {
+            labels[program[n].arg] = static_cast<uint16_t>( resolved.size() );
+        }
+        else
+        {
+            resolved.push_back( program[n] );
+        }
+    }
+    for ( auto& insn : resolved )
+    {
+        if ( insn.op == ulp_insn_t::Op::Bx or insn.op == ulp_insn_t::Op::Bxf )
+        {
+            const auto label{labels.find( insn.arg )};
+            if ( label == labels.end() )
+            {
+                return ESP_ERR_INVALID_ARG;
+            }
+            insn.arg = label->second;
+        }
+    }
+    if ( load_addr + resolved.size() > Host::rtcSlowMemory().size() )
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The words the real instructions would occupy, so data overlapping the program shows up
+    for ( size_t n{0}; n < resolved.size(); ++n )
+    {
+        Host::rtcSlowMemory()[load_addr + n] = 0xDEAD0000 | static_cast<uint32_t>( n );
+    }
+    Host::ulp().program = resolved;
+    Host::ulp().loadAddress = load_addr;
+    *psize = resolved.size();
+    return ESP_OK;
+}
+
+inline auto ulp_set_wakeup_period( size_t, uint32_t period_us ) -> esp_err_t
+{
+    Host::ulp().period = period_us;
+    return ESP_OK;
+}
+
+// Like the hardware, the program first runs when the timer expires, see Host::ulpTick()
+inline auto ulp_run( uint32_t entry_point ) -> esp_err_t
+{
+    Host::ulp().entryPoint = entry_point;
+    Host::ulp().timer = true;
+    return ESP_OK;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+using esp_err_t = int;
+
+static constexpr esp_err_t ESP_OK{0};
+static constexpr esp_err_t ESP_FAIL{-1};
+static constexpr esp_err_t ESP_ERR_INVALID_ARG{0x102};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdio>
+
+// Host build: debug logs are dropped, errors go to stderr
+#define log_d( format, ... ) do {} while ( 0 )
+#define log_i( format, ... ) do {} while ( 0 )
+#define log_e( format, ... ) std::fprintf( stderr, "[E] %s(): " format "\n", __func__, ##__VA_ARGS__ )
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Host build: wake-up sources are only recorded
+
+enum esp_sleep_wakeup_cause_t
+{
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP
+};
+
+namespace Host
+{
+    inline auto ulpWakeup() -> bool&
+    {
+        static bool enabled{false};
+        return enabled;
+    }
+} // namespace Host
+
+inline auto esp_sleep_enable_ulp_wakeup() -> esp_err_t
+{
+    Host::ulpWakeup() = true;
+    return ESP_OK;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Host build: the monotonic clock only moves when a test advances it, the shim tasks read it too
+namespace Host
+{
+    inline auto clock() -> std::atomic<int64_t>&
+    {
+        static std::atomic<int64_t> microseconds{0};
+        return microseconds;
+    }
+
+    inline auto advance( int64_t microseconds ) -> void
+    {
+        clock() += microseconds;
+    }
+} // namespace Host
+
+inline auto esp_timer_get_time() -> int64_t
+{
+    return Host::clock();
+}
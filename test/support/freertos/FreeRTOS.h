@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Host build: FreeRTOS primitives on std threads, one tick is one millisecond of real time
+
+using BaseType_t = int;
+using UBaseType_t = unsigned;
+using TickType_t = uint32_t;
+
+static constexpr TickType_t portMAX_DELAY{0xffffffff};
+static constexpr TickType_t portTICK_PERIOD_MS{1};
+static constexpr BaseType_t pdFALSE{0};
+static constexpr BaseType_t pdTRUE{1};
+static constexpr BaseType_t pdPASS{pdTRUE};
+
+namespace Host
+{
+    // A counter tasks block on, the common part of semaphores and task notifications
+    struct Counter
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        uint32_t value;
+        uint32_t max;
+
+        // Waits up to ticks for a non zero value, then takes one or all of it
+        auto take( TickType_t ticks, bool all ) -> uint32_t
+        {
+            auto lock{std::unique_lock<std::mutex>( this->mutex )};
+            const auto ready{[this]()
+            {
+                return this->value > 0;
+            }};
+            if ( ticks == portMAX_DELAY )
+            {
+                this->changed.wait( lock, ready );
+            }
+            else if ( not this->changed.wait_for( lock, std::chrono::milliseconds( ticks ), ready ) )
+            {
+                return 0;
+            }
+            const auto taken{all ? this->value : 1};
+            this->value -= taken;
+            return taken;
+        }
+
+        auto give() -> bool
+        {
+            auto lock{std::unique_lock<std::mutex>( this->mutex )};
+            if ( this->value >= this->max )
+            {
+                return false;
+            }
+            this->value++;
+            this->changed.notify_all();
+            return true;
+        }
+    };
+} // namespace Host
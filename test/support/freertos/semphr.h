@@ -0,0 +1,37 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Host build: mutexes are binary semaphores given once, without priority inheritance or owner checks
+
+using SemaphoreHandle_t = Host::Counter*;
+
+inline auto xSemaphoreCreateMutex() -> SemaphoreHandle_t
+{
+    return new Host::Counter{{}, {}, 1, 1};
+}
+
+inline auto xSemaphoreCreateBinary() -> SemaphoreHandle_t
+{
+    return new Host::Counter{{}, {}, 0, 1};
+}
+
+inline auto xSemaphoreCreateCounting( UBaseType_t max, UBaseType_t initial ) -> SemaphoreHandle_t
+{
+    return new Host::Counter{{}, {}, initial, max};
+}
+
+inline auto xSemaphoreTake( SemaphoreHandle_t semaphore, TickType_t ticks ) -> BaseType_t
+{
+    return semaphore->take( ticks, false ) > 0 ? pdTRUE : pdFALSE;
+}
+
+inline auto xSemaphoreGive( SemaphoreHandle_t semaphore ) -> BaseType_t
+{
+    return semaphore->give() ? pdTRUE : pdFALSE;
+}
+
+inline auto vSemaphoreDelete( SemaphoreHandle_t semaphore ) -> void
+{
+    delete semaphore;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+#include "FreeRTOS.h"
+
+// Host build: every task is a detached thread, tasks are never deleted so one blocked at exit stays valid
+
+struct Task
+{
+    Host::Counter notification;
+};
+
+using TaskHandle_t = Task*;
+using TaskFunction_t = void( * )( void* );
+
+namespace Host
+{
+    inline auto currentTask() -> TaskHandle_t&
+    {
+        static thread_local TaskHandle_t task{};
+        return task;
+    }
+} // namespace Host
+
+inline auto xTaskCreatePinnedToCore( TaskFunction_t function, const char*, uint32_t, void* arg, UBaseType_t, TaskHandle_t* handle, BaseType_t ) -> BaseType_t
+{
+    const auto task{new Task{{{}, {}, 0, 0xffffffff}}};
+    if ( handle != nullptr )
+    {
+        *handle = task;
+    }
+    std::thread( [function, arg, task]()
+    {
+        Host::currentTask() = task;
+        function( arg );
+    } ).detach();
+    return pdPASS;
+}
+
+inline auto xTaskCreate( TaskFunction_t function, const char* name, uint32_t stack, void* arg, UBaseType_t priority, TaskHandle_t* handle ) -> BaseType_t
+{
+    return xTaskCreatePinnedToCore( function, name, stack, arg, priority, handle, 0 );
+}
+
+// Only valid on a task created through the shim
+inline auto ulTaskNotifyTake( BaseType_t clear, TickType_t ticks ) -> uint32_t
+{
+    return Host::currentTask()->notification.take( ticks, clear == pdTRUE );
+}
+
+inline auto xTaskNotifyGive( TaskHandle_t task ) -> BaseType_t
+{
+    task->notification.give();
+    return pdPASS;
+}
+
+inline auto vTaskDelay( TickType_t ticks ) -> void
+{
+    std::this_thread::sleep_for( std::chrono::milliseconds( ticks ) );
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host build: register "addresses" understood by REG_READ in soc/soc.h
+#define GPIO_IN_REG 0
+#define GPIO_IN1_REG 1
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Arduino.h>
+
+// Host build: the GPIO input registers are packed from the pin levels the tests drive
+inline auto REG_READ( uint32_t reg ) -> uint32_t
+{
+    uint32_t value{0};
+    const auto first{reg == 0 ? 0u : 32u};
+    for ( auto bit{0u}; bit < 32 and first + bit < Host::pins().size(); ++bit )
+    {
+        value |= uint32_t{Host::pins()[first + bit]} << bit;
+    }
+    return value;
+}
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include <Boot.hpp>
+#include <Scheduler.hpp>
+
+// Boot keeps its stages in statics, so the tests run one boot in order: setup(), the loop passes, then readers
+
+static constexpr size_t extras{500};
+static auto order{std::array<const char*, 8> {}};
+static auto ordered{size_t{0}};
+
+static auto record( const char* name, int64_t us ) -> void
+{
+    order[ordered++] = name;
+    Host::advance( us );
+}
+
+static auto pass() -> void
+{
+    Host::advance( 10000 );
+    Scheduler::process();
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_immediate_stages_run_in_order_with_timings()
+{
+    Host::clock() = 1000;
+    Boot::stage( "peripherals", []()
+    {
+        record( "peripherals", 2000 );
+    } );
+    Boot::stage( "infos", []()
+    {
+        record( "infos", 50000 );
+        Boot::reading();
+    }, {"peripherals"} );
+    Boot::stage( "database", []()
+    {
+        record( "database", 400000 );
+    }, {"peripherals"}, Boot::Mode::Deferred );
+    Boot::stage( "network", []()
+    {
+        record( "network", 900000 );
+    }, {"database"}, Boot::Mode::Deferred );
+    for ( size_t n{0}; n < extras; ++n )
+    {
+        Boot::stage( "extra", []()
+        {
+            Host::advance( 10 );
+        }, {}, Boot::Mode::Deferred );
+    }
+    Boot::run();
+
+    TEST_ASSERT_EQUAL_size_t( 2, ordered );
+    TEST_ASSERT_EQUAL_STRING( "peripherals", order[0] );
+    TEST_ASSERT_EQUAL_STRING( "infos", order[1] );
+
+    const auto statistics{Boot::Statistics::get()};
+    TEST_ASSERT_EQUAL_size_t( 4 + extras, statistics.stages.size() );
+    TEST_ASSERT_EQUAL_UINT32( 1000, statistics.stages[0].start );
+    TEST_ASSERT_EQUAL_UINT32( 2000, statistics.stages[0].duration );
+    TEST_ASSERT_EQUAL_UINT32( 3000, statistics.stages[1].start );
+    TEST_ASSERT_FALSE( statistics.stages[2].done );
+    // Sampling starts before the slow stages
+    TEST_ASSERT_EQUAL_UINT32( 53000, statistics.firstReading );
+}
+
+static void test_deferred_stages_run_one_per_pass()
+{
+    pass();
+    TEST_ASSERT_EQUAL_size_t( 3, ordered );
+    TEST_ASSERT_EQUAL_STRING( "database", order[2] );
+    pass();
+    TEST_ASSERT_EQUAL_size_t( 4, ordered );
+    TEST_ASSERT_EQUAL_STRING( "network", order[3] );
+
+    const auto statistics{Boot::Statistics::get()};
+    TEST_ASSERT_TRUE( statistics.stages[3].done );
+    TEST_ASSERT_EQUAL_UINT32( 900000, statistics.stages[3].duration );
+}
+
+static void test_later_readings_are_ignored()
+{
+    const auto first{Boot::Statistics::get().firstReading};
+    Host::advance( 1000 );
+    Boot::reading();
+    TEST_ASSERT_EQUAL_UINT32( first, Boot::Statistics::get().firstReading );
+}
+
+// Copies the statistics from another thread, as the web handlers do, while the remaining stages run
+static void test_statistics_copy_while_stages_run()
+{
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> copies{0};
+    std::atomic<uint32_t> torn{0};
+    auto reader{std::thread( [&]()
+    {
+        while ( not done )
+        {
+            const auto statistics{Boot::Statistics::get()};
+            for ( const auto& timing : statistics.stages )
+            {
+                if ( timing.name == nullptr or ( timing.done and timing.start == 0 ) )
+                {
+                    torn++;
+                }
+            }
+            copies++;
+        }
+    } )};
+    // The passes below can finish before the thread is scheduled at all
+    while ( copies == 0 )
+    {
+        std::this_thread::yield();
+    }
+
+    for ( size_t n{0}; n < extras; ++n )
+    {
+        pass();
+    }
+    done = true;
+    reader.join();
+
+    const auto statistics{Boot::Statistics::get()};
+    for ( const auto& timing : statistics.stages )
+    {
+        TEST_ASSERT_TRUE( timing.done );
+    }
+    TEST_ASSERT_GREATER_THAN( 0, copies.load() );
+    TEST_ASSERT_EQUAL_UINT32( 0, torn.load() );
+
+    // The step retired itself, later passes run nothing
+    const auto last{Host::clock().load()};
+    pass();
+    TEST_ASSERT_EQUAL_INT64( last + 10000, Host::clock().load() );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_immediate_stages_run_in_order_with_timings );
+    RUN_TEST( test_deferred_stages_run_one_per_pass );
+    RUN_TEST( test_later_readings_are_ignored );
+    RUN_TEST( test_statistics_copy_while_stages_run );
+    return UNITY_END();
+}
@@ -0,0 +1,178 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Bus.hpp>
+#include <Scheduler.hpp>
+
+// Runs the bus task on a thread of the FreeRTOS shim. Devices are closures recording what the bus task ran, a gate
+// transaction holds the task busy while a test fills the queues.
+
+static auto order{std::vector<std::string>{}};
+static SemaphoreHandle_t gate{};
+static SemaphoreHandle_t started{};
+
+static auto record( const char* name, bool ok = true ) -> Bus::Transaction
+{
+    return [name, ok]()
+    {
+        order.push_back( name );
+        return ok;
+    };
+}
+
+// Keeps the bus task inside a transaction until release()
+static auto hold() -> void
+{
+    Bus::submit( Bus::Device::Lcd, Bus::Priority::High, []()
+    {
+        xSemaphoreGive( started );
+        xSemaphoreTake( gate, portMAX_DELAY );
+        return true;
+    } );
+    xSemaphoreTake( started, portMAX_DELAY );
+}
+
+static auto release() -> void
+{
+    xSemaphoreGive( gate );
+}
+
+// Waits until the bus task ran everything queued so far
+static auto drain() -> void
+{
+    const auto done{xSemaphoreCreateBinary()};
+    while ( not Bus::submit( Bus::Device::Lcd, Bus::Priority::Low, [done]()
+    {
+        xSemaphoreGive( done );
+        return true;
+    } ) )
+    {
+        vTaskDelay( 1 );
+    }
+    xSemaphoreTake( done, portMAX_DELAY );
+    vSemaphoreDelete( done );
+}
+
+// One pass of the loop task, where completions run
+static auto dispatch() -> void
+{
+    Host::advance( 10000 );
+    Scheduler::process();
+}
+
+void setUp()
+{
+    if ( gate == nullptr )
+    {
+        gate = xSemaphoreCreateBinary();
+        started = xSemaphoreCreateBinary();
+        Bus::init();
+    }
+    order.clear();
+}
+
+void tearDown()
+{
+    drain();
+    dispatch();
+}
+
+static void test_higher_priorities_run_first()
+{
+    hold();
+    Bus::submit( Bus::Device::Lcd, Bus::Priority::Low, record( "lcd 1" ) );
+    Bus::submit( Bus::Device::Ds3231, Bus::Priority::Normal, record( "rtc" ) );
+    Bus::submit( Bus::Device::Bme280, Bus::Priority::High, record( "bme 1" ) );
+    Bus::submit( Bus::Device::Lcd, Bus::Priority::Low, record( "lcd 2" ) );
+    Bus::submit( Bus::Device::Bme280, Bus::Priority::High, record( "bme 2" ) );
+    release();
+    drain();
+
+    const auto expected{std::vector<std::string>{"bme 1", "bme 2", "rtc", "lcd 1", "lcd 2"}};
+    TEST_ASSERT_TRUE( expected == order );
+}
+
+static void test_completions_run_on_the_loop_task()
+{
+    static auto calls{0};
+    static auto result{true};
+    static auto thread{std::thread::id{}};
+    calls = 0;
+
+    Bus::submit( Bus::Device::Ads1115, Bus::Priority::Normal, record( "ads", false ), []( bool ok )
+    {
+        calls++;
+        result = ok;
+        thread = std::this_thread::get_id();
+    } );
+    drain();
+    TEST_ASSERT_EQUAL( 0, calls );
+
+    dispatch();
+    TEST_ASSERT_EQUAL( 1, calls );
+    TEST_ASSERT_FALSE( result );
+    TEST_ASSERT_TRUE( std::this_thread::get_id() == thread );
+
+    dispatch();
+    TEST_ASSERT_EQUAL( 1, calls );
+}
+
+static void test_full_queue_rejects()
+{
+    const auto before{Bus::Statistics::get()};
+    hold();
+    for ( auto n{0}; n < 16; ++n )
+    {
+        TEST_ASSERT_TRUE( Bus::submit( Bus::Device::Lcd, Bus::Priority::Normal, record( "row" ) ) );
+    }
+    TEST_ASSERT_FALSE( Bus::submit( Bus::Device::Lcd, Bus::Priority::Normal, record( "dropped" ) ) );
+    // Each priority has its own queue
+    TEST_ASSERT_TRUE( Bus::submit( Bus::Device::Bme280, Bus::Priority::High, record( "bme" ) ) );
+    release();
+    drain();
+
+    TEST_ASSERT_EQUAL_UINT32( before.rejected + 1, Bus::Statistics::get().rejected );
+    TEST_ASSERT_EQUAL_size_t( 17, order.size() );
+    TEST_ASSERT_EQUAL_STRING( "bme", order.front().data() );
+}
+
+static void test_execute_returns_the_transaction_result()
+{
+    const auto before{Bus::Statistics::get().devices[Bus::Device::Ds3231]};
+    TEST_ASSERT_TRUE( Bus::execute( Bus::Device::Ds3231, record( "ok" ) ) );
+    TEST_ASSERT_FALSE( Bus::execute( Bus::Device::Ds3231, record( "error", false ) ) );
+    // execute() returns from inside the transaction, the counters follow once the bus task finished it
+    drain();
+
+    const auto after{Bus::Statistics::get().devices[Bus::Device::Ds3231]};
+    TEST_ASSERT_EQUAL_UINT32( before.transactions + 2, after.transactions );
+    TEST_ASSERT_EQUAL_UINT32( before.errors + 1, after.errors );
+}
+
+static void test_latency_includes_time_queued()
+{
+    hold();
+    Bus::submit( Bus::Device::Bme280, Bus::Priority::High, record( "bme" ) );
+    Host::advance( 5000 );
+    release();
+    drain();
+
+    const auto counters{Bus::Statistics::get().devices[Bus::Device::Bme280]};
+    TEST_ASSERT_EQUAL_UINT32( 5000, counters.latencyLast );
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32( 5000, counters.latencyMax );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_higher_priorities_run_first );
+    RUN_TEST( test_completions_run_on_the_loop_task );
+    RUN_TEST( test_full_queue_rejects );
+    RUN_TEST( test_execute_returns_the_transaction_result );
+    RUN_TEST( test_latency_includes_time_queued );
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <Button.hpp>
+
+// Edges are injected through the captured GPIO interrupt with the host clock, the pin being active low with a pull-up
+
+static constexpr uint8_t pin{4};
+
+static auto at( uint32_t ms, uint8_t level ) -> void
+{
+    Host::clock() = int64_t{ms} * 1000;
+    Host::drive( pin, level );
+}
+
+static auto until( uint32_t ms ) -> void
+{
+    Host::clock() = int64_t{ms} * 1000;
+}
+
+void setUp()
+{
+    Host::clock() = 0;
+    Host::pins().fill( HIGH );
+    Host::interrupts().fill( Host::Interrupt{} );
+}
+
+void tearDown()
+{
+}
+
+static void test_single_press()
+{
+    Button button{pin};
+    auto pressed{0};
+    button.onPress( [&pressed]() { ++pressed; } );
+    button.initInterrupt();
+
+    at( 0, LOW );
+    until( 10 );
+    button.process();
+    TEST_ASSERT_EQUAL( 0, pressed );
+
+    until( 50 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, pressed );
+
+    until( 80 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, pressed );
+}
+
+static void test_bounce_is_rejected()
+{
+    Button button{pin};
+    auto pressed{0};
+    button.onPress( [&pressed]() { ++pressed; } );
+    button.initInterrupt();
+
+    at( 0, LOW );
+    at( 5, HIGH );
+    at( 10, LOW );
+    at( 15, HIGH );
+    at( 22, LOW );
+    at( 40, HIGH );
+    until( 200 );
+    button.process();
+    TEST_ASSERT_EQUAL( 0, pressed );
+}
+
+static void test_long_press_replayed_late()
+{
+    Button button{pin};
+    auto pressed{0};
+    auto released{0};
+    auto pressedBeforeRelease{false};
+    button.onPress( 1000, [&pressed]() { ++pressed; }, [&]()
+    {
+        pressedBeforeRelease = pressed == 1;
+        ++released;
+    } );
+    button.initInterrupt();
+
+    at( 0, LOW );
+    at( 1500, HIGH );
+    // process() did not run during the whole press, the queued edges still time it
+    until( 3000 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, pressed );
+    TEST_ASSERT_EQUAL( 1, released );
+    TEST_ASSERT_TRUE( pressedBeforeRelease );
+}
+
+static void test_short_press_is_not_long()
+{
+    Button button{pin};
+    auto pressed{0};
+    button.onPress( 1000, [&pressed]() { ++pressed; } );
+    button.initInterrupt();
+
+    at( 0, LOW );
+    at( 400, HIGH );
+    until( 3000 );
+    button.process();
+    TEST_ASSERT_EQUAL( 0, pressed );
+}
+
+static void test_double_press()
+{
+    Button button{pin};
+    auto doubled{0};
+    button.onPress( 500, 2, [&doubled]() { ++doubled; } );
+    button.initInterrupt();
+
+    at( 0, LOW );
+    at( 100, HIGH );
+    at( 200, LOW );
+    at( 300, HIGH );
+    until( 1000 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, doubled );
+
+    // Two presses too far apart are not a double press
+    at( 2000, LOW );
+    at( 2100, HIGH );
+    until( 2800 );
+    button.process();
+    at( 2900, LOW );
+    at( 3000, HIGH );
+    until( 4000 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, doubled );
+}
+
+static void test_overflow_resyncs_to_pin()
+{
+    Button button{pin};
+    auto pressed{0};
+    button.onPress( [&pressed]() { ++pressed; } );
+    button.initInterrupt();
+
+    // More edges than the queue holds, ending held down
+    auto level{HIGH};
+    for ( auto n{0}; n < 41; ++n )
+    {
+        level = level == HIGH ? LOW : HIGH;
+        at( n, level );
+    }
+    TEST_ASSERT_EQUAL( LOW, level );
+
+    until( 100 );
+    button.process();
+    until( 200 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, pressed );
+
+    at( 300, HIGH );
+    at( 400, LOW );
+    until( 500 );
+    button.process();
+    TEST_ASSERT_EQUAL( 2, pressed );
+}
+
+static void test_polling_mode()
+{
+    Button button{pin};
+    auto pressed{0};
+    button.onPress( [&pressed]() { ++pressed; } );
+    button.init();
+
+    Host::pins()[pin] = LOW;
+    until( 0 );
+    button.process();
+    until( 50 );
+    button.process();
+    TEST_ASSERT_EQUAL( 1, pressed );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_single_press );
+    RUN_TEST( test_bounce_is_rejected );
+    RUN_TEST( test_long_press_replayed_late );
+    RUN_TEST( test_short_press_is_not_long );
+    RUN_TEST( test_double_press );
+    RUN_TEST( test_overflow_resyncs_to_pin );
+    RUN_TEST( test_polling_mode );
+    return UNITY_END();
+}
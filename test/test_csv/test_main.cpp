@@ -0,0 +1,168 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Csv.hpp>
+#include <Utils.hpp>
+
+static constexpr size_t sensors{3};
+static constexpr size_t rowMaxLen{Csv::rowMaxLen( 16 )};
+// Space AsyncWebServer usually offers a chunk callback on a full TCP segment
+static constexpr size_t chunkSize{1436};
+
+struct Row
+{
+    int64_t id;
+    std::time_t dateTime;
+    double values[3 + sensors];
+};
+
+static auto rows( size_t count ) -> std::vector<Row>
+{
+    auto rows{std::vector<Row>( count )};
+    for ( size_t n{0}; n < count; ++n )
+    {
+        rows[n] = Row{static_cast<int64_t>( n + 1 ), 1600000000 + static_cast<std::time_t>( n ) * 300, {21.25 + n % 7, 48.5, 1013.25, 0.125 * ( n % 80 ), 1.5, n % 50 == 0 ? NAN : -0.75}};
+    }
+    return rows;
+}
+
+// Runs a whole export through Csv::Chunks with chunks of size bytes
+static auto stream( const std::vector<Row>& rows, size_t size, size_t* chunks ) -> std::string
+{
+    auto csv{Csv::Chunks<rowMaxLen> {}};
+    csv.begin( []( char* first )
+    {
+        return Csv::header( first, sensors );
+    } );
+
+    auto output{std::string{}};
+    auto buffer{std::vector<char>( size )};
+    auto next{size_t{0}};
+    *chunks = 0;
+    while ( true )
+    {
+        const auto last{csv.fill( buffer.data(), buffer.data() + size, [&]( char* first ) -> char*
+        {
+            if ( next == rows.size() )
+            {
+                return nullptr;
+            }
+            const auto& row{rows[next++]};
+            return Csv::row( first, row.id, row.dateTime, row.values[0], row.values[1], row.values[2], row.values + 3, sensors );
+        } )};
+        if ( last == buffer.data() )
+        {
+            return output;
+        }
+        output.append( buffer.data(), last );
+        ( *chunks )++;
+    }
+}
+
+// The export as it was: a stringstream with a decimal comma locale, one row per chunk callback
+class Comma : public std::numpunct<char>
+{
+    protected:
+        auto do_decimal_point() const -> char override
+        {
+            return ',';
+        }
+};
+
+static auto legacy( const std::vector<Row>& rows, size_t size ) -> size_t
+{
+    auto stream{std::stringstream{}};
+    stream.imbue( std::locale( std::locale::classic(), new Comma ) );
+    auto buffer{std::vector<char>( size )};
+    auto total{size_t{0}};
+    for ( const auto& row : rows )
+    {
+        stream << row.id << ';' << Utils::DateTime::toString( std::chrono::system_clock::from_time_t( row.dateTime ) );
+        for ( const auto value : row.values )
+        {
+            stream << ';' << value;
+        }
+        stream << "\r\n";
+        total += stream.readsome( buffer.data(), size );
+    }
+    return total;
+}
+
+void setUp()
+{
+    setenv( "TZ", "UTC0", 1 );
+    tzset();
+}
+
+void tearDown()
+{
+}
+
+static void test_row_format()
+{
+    char buffer[rowMaxLen];
+    const double values[]{12.5, -0.0004, NAN};
+    const auto last{Csv::row( buffer, 42, 1600000000, 21.125, 48.0, 1013.2504, values, 3 )};
+    TEST_ASSERT_EQUAL_STRING( "42;2020-09-13 12:26:40;21,125;48;1013,25;12,5;0;nan\r\n", std::string( buffer, last ).data() );
+
+    const auto header{Csv::header( buffer, 2 )};
+    TEST_ASSERT_EQUAL_STRING( "id;datetime;temperature;humidity;pressure;sensor_0;sensor_1\r\n", std::string( buffer, header ).data() );
+}
+
+static void test_chunks_reassemble_for_any_size()
+{
+    const auto data{rows( 500 )};
+    auto chunks{size_t{0}};
+    const auto reference{stream( data, 1 << 20, &chunks )};
+    TEST_ASSERT_EQUAL_size_t( 1, chunks );
+
+    for ( const auto size : {size_t{1}, size_t{7}, size_t{64}, size_t{rowMaxLen - 1}, size_t{rowMaxLen}, chunkSize} )
+    {
+        const auto output{stream( data, size, &chunks )};
+        TEST_ASSERT_EQUAL_size_t( reference.size(), output.size() );
+        TEST_ASSERT_TRUE( reference == output );
+        // Every chunk but the last one is full
+        TEST_ASSERT_EQUAL_size_t( ( reference.size() + size - 1 ) / size, chunks );
+    }
+}
+
+static void test_benchmark_rows_per_second()
+{
+    // One year of samples every 5 minutes
+    const auto data{rows( 365 * 288 )};
+
+    auto chunks{size_t{0}};
+    auto begin{std::chrono::steady_clock::now()};
+    const auto output{stream( data, chunkSize, &chunks )};
+    const auto elapsed{std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count()};
+
+    begin = std::chrono::steady_clock::now();
+    const auto legacyBytes{legacy( data, chunkSize )};
+    const auto legacyElapsed{std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count()};
+
+    char message[200];
+    std::snprintf( message, sizeof( message ), "%u rows, %u bytes in %u chunks: %.0f rows/s, %.1f MB/s; one row per chunk with a stringstream: %.0f rows/s",
+                   static_cast<unsigned>( data.size() ), static_cast<unsigned>( output.size() ), static_cast<unsigned>( chunks ),
+                   data.size() / elapsed, output.size() / elapsed / 1e6, data.size() / legacyElapsed );
+    TEST_MESSAGE( message );
+
+    TEST_ASSERT_GREATER_THAN( legacyBytes / 2, output.size() );
+    TEST_ASSERT_LESS_THAN( legacyElapsed, elapsed );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_row_format );
+    RUN_TEST( test_chunks_reassemble_for_any_size );
+    RUN_TEST( test_benchmark_rows_per_second );
+    return UNITY_END();
+}
@@ -0,0 +1,291 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <sqlite3.h>
+#include <string>
+
+#include <DatabaseQueries.hpp>
+
+// Runs the SENSORS_DATA statements on an in-memory SQLite of the host, needs the sqlite3 development package
+
+static constexpr size_t sensorCount{3};
+static constexpr int64_t sampleInterval{300};
+// A unit sampling every 5 minutes for 19 years
+static constexpr int64_t benchmarkRows{2000000};
+
+static sqlite3* db{};
+
+static auto execute( const std::string& query ) -> void
+{
+    char* error{};
+    if ( sqlite3_exec( db, query.data(), nullptr, nullptr, &error ) != SQLITE_OK )
+    {
+        TEST_FAIL_MESSAGE( error );
+    }
+}
+
+static auto prepare( const std::string& query ) -> sqlite3_stmt*
+{
+    sqlite3_stmt* res{};
+    if ( sqlite3_prepare_v2( db, query.data(), query.size(), &res, nullptr ) != SQLITE_OK )
+    {
+        TEST_FAIL_MESSAGE( sqlite3_errmsg( db ) );
+    }
+    return res;
+}
+
+static auto fill( int64_t rows ) -> void
+{
+    execute( "BEGIN TRANSACTION" );
+    const auto res{prepare( DatabaseQueries::insert( sensorCount ) )};
+    for ( int64_t n{0}; n < rows; ++n )
+    {
+        sqlite3_bind_int64( res, 1, n * sampleInterval );
+        for ( int column{2}; column <= 4 + static_cast<int>( sensorCount ); ++column )
+        {
+            sqlite3_bind_double( res, column, n % 100 );
+        }
+        sqlite3_step( res );
+        sqlite3_reset( res );
+    }
+    sqlite3_finalize( res );
+    execute( "COMMIT TRANSACTION" );
+}
+
+static auto plan( bool byId, bool byStart, bool byEnd, bool byAfter ) -> std::string
+{
+    const auto res{prepare( "EXPLAIN QUERY PLAN " + DatabaseQueries::select( sensorCount, byId, byStart, byEnd, byAfter ) )};
+    auto details{std::string{}};
+    while ( sqlite3_step( res ) == SQLITE_ROW )
+    {
+        details += reinterpret_cast<const char*>( sqlite3_column_text( res, 3 ) );
+        details += "; ";
+    }
+    sqlite3_finalize( res );
+    return details;
+}
+
+// Binds like Database::Statement and returns the rows read and the id of the last one
+static auto run( sqlite3_stmt* res, int64_t id, int64_t start, int64_t end, int64_t afterDateTime, int64_t afterId, int64_t limit, int64_t* last ) -> int64_t
+{
+    sqlite3_bind_int64( res, 1, id );
+    sqlite3_bind_int64( res, 2, start );
+    sqlite3_bind_int64( res, 3, end );
+    sqlite3_bind_int64( res, 4, afterDateTime );
+    sqlite3_bind_int64( res, 5, afterId );
+    sqlite3_bind_int64( res, 6, limit );
+    auto rows{int64_t{0}};
+    while ( sqlite3_step( res ) == SQLITE_ROW )
+    {
+        *last = sqlite3_column_int64( res, 0 );
+        rows++;
+    }
+    sqlite3_reset( res );
+    return rows;
+}
+
+static auto open( const char* path ) -> void
+{
+    sqlite3_open( path, &db );
+    execute( DatabaseQueries::table );
+    for ( size_t n{0}; n < sensorCount; ++n )
+    {
+        execute( DatabaseQueries::addColumn( "SENSORS_DATA", DatabaseQueries::sensorColumn( n ) ) );
+    }
+    execute( DatabaseQueries::index );
+}
+
+void setUp()
+{
+    open( ":memory:" );
+}
+
+void tearDown()
+{
+    sqlite3_close( db );
+    db = nullptr;
+}
+
+static void test_every_filter_is_an_index_range_without_sort()
+{
+    fill( 1000 );
+    execute( "ANALYZE" );
+    for ( auto mask{0}; mask < 16; ++mask )
+    {
+        const auto byId{( mask & 1 ) != 0};
+        const auto byStart{( mask & 2 ) != 0};
+        const auto byEnd{( mask & 4 ) != 0};
+        const auto byAfter{( mask & 8 ) != 0};
+        const auto details{plan( byId, byStart, byEnd, byAfter )};
+        TEST_MESSAGE( details.data() );
+
+        TEST_ASSERT_TRUE_MESSAGE( details.find( "TEMP B-TREE" ) == std::string::npos, details.data() );
+        if ( mask == 0 )
+        {
+            // Nothing to seek on, the rows come in index order up to the limit
+            TEST_ASSERT_TRUE_MESSAGE( details.find( "DATE_TIME_INDEX" ) != std::string::npos, details.data() );
+            continue;
+        }
+        TEST_ASSERT_TRUE_MESSAGE( details.find( "SEARCH" ) != std::string::npos, details.data() );
+        TEST_ASSERT_TRUE_MESSAGE( details.find( "SCAN" ) == std::string::npos, details.data() );
+    }
+}
+
+static void test_cursor_pages_through_every_row_once()
+{
+    fill( 1000 );
+    const auto res{prepare( DatabaseQueries::select( sensorCount, false, true, true, true ) )};
+    auto afterDateTime{int64_t{-1}};
+    auto afterId{int64_t{0}};
+    auto total{int64_t{0}};
+    while ( true )
+    {
+        sqlite3_bind_int64( res, 2, 0 );
+        sqlite3_bind_int64( res, 3, 999 * sampleInterval );
+        sqlite3_bind_int64( res, 4, afterDateTime );
+        sqlite3_bind_int64( res, 5, afterId );
+        sqlite3_bind_int64( res, 6, 64 );
+        auto rows{0};
+        while ( sqlite3_step( res ) == SQLITE_ROW )
+        {
+            const auto id{sqlite3_column_int64( res, 0 )};
+            const auto dateTime{sqlite3_column_int64( res, 1 )};
+            TEST_ASSERT_EQUAL_INT64( afterId + 1, id );
+            TEST_ASSERT_GREATER_THAN( afterDateTime, dateTime );
+            afterId = id;
+            afterDateTime = dateTime;
+            rows++;
+        }
+        sqlite3_reset( res );
+        if ( rows == 0 )
+        {
+            break;
+        }
+        total += rows;
+    }
+    sqlite3_finalize( res );
+    TEST_ASSERT_EQUAL_INT64( 1000, total );
+}
+
+static void test_id_only_starts_at_id()
+{
+    fill( 1000 );
+    const auto res{prepare( DatabaseQueries::select( sensorCount, true, false, false, false ) )};
+    auto last{int64_t{0}};
+    TEST_ASSERT_EQUAL_INT64( 10, run( res, 991, 0, 0, 0, 0, -1, &last ) );
+    TEST_ASSERT_EQUAL_INT64( 1000, last );
+    TEST_ASSERT_EQUAL_INT64( 5, run( res, 500, 0, 0, 0, 0, 5, &last ) );
+    TEST_ASSERT_EQUAL_INT64( 504, last );
+    sqlite3_finalize( res );
+}
+
+static void test_benchmark_range_scan()
+{
+    auto begin{std::chrono::steady_clock::now()};
+    fill( benchmarkRows );
+    const auto filled{std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - begin ).count()};
+
+    // The filter as it was, with every predicate folded into IFNULL() and no usable range
+    auto legacy{std::string{"SELECT ID, DATE_TIME, TEMPERATURE, HUMIDITY, PRESSURE, SENSOR_1, SENSOR_2, SENSOR_3 FROM SENSORS_DATA "
+                            "WHERE ( ID >= IFNULL( ?1, ID ) ) AND ( DATE_TIME >= IFNULL( ?2, DATE_TIME ) ) AND ( DATE_TIME <= IFNULL( ?3, DATE_TIME ) ) "
+                            "AND ( ( DATE_TIME, ID ) > ( ?4, ?5 ) ) ORDER BY DATE_TIME ASC LIMIT ?6"}};
+
+    // The last day of data, as the data page asks for it
+    const auto end{( benchmarkRows - 1 ) * sampleInterval};
+    const auto start{end - 86400};
+    const auto measure{[&]( const std::string & query, int64_t* rows ) -> double
+    {
+        const auto res{prepare( query )};
+        auto last{int64_t{0}};
+        const auto begin{std::chrono::steady_clock::now()};
+        static constexpr auto repeat{5};
+        for ( auto n{0}; n < repeat; ++n )
+        {
+            *rows = run( res, 1, start, end, -1, 0, -1, &last );
+        }
+        const auto elapsed{std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - begin ).count() / repeat};
+        sqlite3_finalize( res );
+        return elapsed;
+    }};
+
+    auto legacyRows{int64_t{0}};
+    auto rangeRows{int64_t{0}};
+    const auto legacyTime{measure( legacy, &legacyRows )};
+    const auto rangeTime{measure( DatabaseQueries::select( sensorCount, false, true, true, true ), &rangeRows )};
+
+    char message[200];
+    std::snprintf( message, sizeof( message ), "%lld rows filled in %lld ms, last day (%lld rows): full scan %.0f us, index range %.0f us",
+                   static_cast<long long>( benchmarkRows ), static_cast<long long>( filled ), static_cast<long long>( rangeRows ), legacyTime, rangeTime );
+    TEST_MESSAGE( message );
+
+    TEST_ASSERT_EQUAL_INT64( 289, rangeRows );
+    TEST_ASSERT_EQUAL_INT64( legacyRows, rangeRows );
+    TEST_ASSERT_LESS_THAN( legacyTime / 100, rangeTime );
+}
+
+// Stores samples in a database file, one autocommit per sample when batch is 1, as Database::insert() did before
+// the storage task, otherwise committing every batch samples
+static auto measureCommits( int64_t samples, int64_t batch ) -> double
+{
+    static constexpr auto path{"test_batching.db"};
+
+    sqlite3_close( db );
+    std::remove( path );
+    open( path );
+
+    const auto res{prepare( DatabaseQueries::insert( sensorCount ) )};
+    const auto begin{std::chrono::steady_clock::now()};
+    for ( int64_t n{0}; n < samples; ++n )
+    {
+        if ( batch > 1 and n % batch == 0 )
+        {
+            execute( "BEGIN TRANSACTION" );
+        }
+        sqlite3_bind_int64( res, 1, n * sampleInterval );
+        for ( int column{2}; column <= 4 + static_cast<int>( sensorCount ); ++column )
+        {
+            sqlite3_bind_double( res, column, n % 100 );
+        }
+        sqlite3_step( res );
+        sqlite3_reset( res );
+        if ( batch > 1 and ( n % batch == batch - 1 or n == samples - 1 ) )
+        {
+            execute( "COMMIT TRANSACTION" );
+        }
+    }
+    const auto elapsed{std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - begin ).count()};
+    sqlite3_finalize( res );
+
+    sqlite3_close( db );
+    std::remove( path );
+    open( ":memory:" );
+    return elapsed / samples;
+}
+
+static void test_benchmark_batched_commits()
+{
+    static constexpr int64_t samples{384};
+
+    const auto autocommit{measureCommits( samples, 1 )};
+    const auto batched{measureCommits( samples, 12 )};
+    const auto full{measureCommits( samples, 32 )};
+
+    char message[160];
+    std::snprintf( message, sizeof( message ), "per sample: autocommit %.0f us, batches of 12 %.0f us, batches of 32 %.0f us", autocommit, batched, full );
+    TEST_MESSAGE( message );
+
+    TEST_ASSERT_LESS_THAN( autocommit, batched );
+    TEST_ASSERT_LESS_THAN( autocommit, full );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_every_filter_is_an_index_range_without_sort );
+    RUN_TEST( test_cursor_pages_through_every_row_once );
+    RUN_TEST( test_id_only_starts_at_id );
+    RUN_TEST( test_benchmark_range_scan );
+    RUN_TEST( test_benchmark_batched_commits );
+    return UNITY_END();
+}
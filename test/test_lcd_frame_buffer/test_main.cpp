@@ -0,0 +1,165 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <array>
+
+#include <LcdFrameBuffer.hpp>
+#include <LcdGlyphCache.hpp>
+
+// Replays screen updates the way Display draws them: rows and bar glyphs go into the frame buffer, flush() then
+// sends the panel only what changed. The tests share the frame and run in order, as on one screen.
+
+// Counts what the HD44780 behind the I2C expander would receive, one send() per command or character byte
+class Panel : public LCD
+{
+    public:
+        size_t bytes{};
+
+        void send( uint8_t, uint8_t ) override
+        {
+            this->bytes++;
+        }
+};
+
+static constexpr uint8_t columns{20};
+static constexpr uint8_t rows{4};
+
+static LcdFrameBuffer frame{};
+static LcdGlyphCache glyphs{&frame};
+static Panel panel{};
+
+static constexpr uint8_t half[8]{0b11111, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11111};
+static constexpr uint8_t quarter[8]{0b11111, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11111};
+
+static auto draw( uint8_t row, const char* text ) -> void
+{
+    frame.setCursor( 0, row );
+    frame.print( text );
+}
+
+// flush() reports the bytes it sent, the panel counts what it actually received
+static auto flushRow( uint8_t row ) -> size_t
+{
+    const auto before{panel.bytes};
+    const auto sent{frame.flush( &panel, row )};
+    TEST_ASSERT_EQUAL_size_t( panel.bytes - before, sent );
+    return sent;
+}
+
+static auto pattern( uint8_t seed ) -> std::array<uint8_t, 8>
+{
+    auto glyph{std::array<uint8_t, 8> {}};
+    glyph.fill( seed & 0b11111 );
+    return glyph;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_first_flush_sends_every_cell_and_glyph()
+{
+    frame.begin( columns, rows );
+    draw( 0, "Ext  42.5%          " );
+    draw( 1, "Sup  80.0%          " );
+    draw( 2, "Inf  13.1%          " );
+
+    const auto sent{frame.flush( &panel )};
+    // The 8 glyph slots, then a cursor move and 20 cells per row
+    TEST_ASSERT_EQUAL_size_t( 8 * ( 1 + 8 ) + rows * ( 1 + columns ), sent );
+    TEST_ASSERT_EQUAL_size_t( panel.bytes, sent );
+}
+
+static void test_unchanged_rows_send_nothing()
+{
+    draw( 0, "Ext  42.5%          " );
+    draw( 1, "Sup  80.0%          " );
+    draw( 2, "Inf  13.1%          " );
+    for ( uint8_t row{0}; row < rows; ++row )
+    {
+        TEST_ASSERT_EQUAL_size_t( 0, flushRow( row ) );
+    }
+}
+
+static void test_changed_value_sends_its_cells()
+{
+    // A cursor move and the digit
+    draw( 0, "Ext  42.6%          " );
+    TEST_ASSERT_EQUAL_size_t( 2, flushRow( 0 ) );
+
+    // One clean cell between two dirty ones is rewritten rather than skipped with a second cursor move
+    draw( 0, "Ext  43.7%          " );
+    TEST_ASSERT_EQUAL_size_t( 4, flushRow( 0 ) );
+
+    // Farther apart, each run gets its own cursor move
+    draw( 1, "Xup  80.0%         !" );
+    TEST_ASSERT_EQUAL_size_t( 4, flushRow( 1 ) );
+}
+
+static void test_shared_glyph_is_defined_once()
+{
+    uint8_t first{};
+    uint8_t second{};
+    TEST_ASSERT_TRUE( glyphs.acquire( half, &first ) );
+    TEST_ASSERT_TRUE( glyphs.acquire( half, &second ) );
+    TEST_ASSERT_EQUAL_UINT8( first, second );
+
+    frame.setCursor( 10, 0 );
+    frame.write( first );
+    frame.setCursor( 10, 1 );
+    frame.write( second );
+
+    // The slot goes out with the first row using it, the second row only writes its cell
+    TEST_ASSERT_EQUAL_size_t( 1 + 8 + 2, flushRow( 0 ) );
+    TEST_ASSERT_EQUAL_size_t( 2, flushRow( 1 ) );
+
+    glyphs.release( first );
+    glyphs.release( second );
+}
+
+static void test_evicted_glyph_is_redefined_in_place()
+{
+    // Hold every other slot, the one released above is then the only candidate
+    uint8_t held[LcdGlyphCache::slotsCount - 1];
+    for ( uint8_t n{0}; n < LcdGlyphCache::slotsCount - 1; ++n )
+    {
+        TEST_ASSERT_TRUE( glyphs.acquire( pattern( n + 1 ).data(), &held[n] ) );
+    }
+    for ( uint8_t row{0}; row < rows; ++row )
+    {
+        flushRow( row );
+    }
+
+    uint8_t slot{};
+    TEST_ASSERT_TRUE( glyphs.acquire( quarter, &slot ) );
+    // Both rows already point at the slot, redefining it redraws them without touching a cell
+    TEST_ASSERT_EQUAL_size_t( 1 + 8, flushRow( 0 ) );
+    TEST_ASSERT_EQUAL_size_t( 0, flushRow( 1 ) );
+
+    // With every slot held a new pattern is refused
+    uint8_t refused{};
+    TEST_ASSERT_FALSE( glyphs.acquire( pattern( 31 ).data(), &refused ) );
+}
+
+static void test_invalidate_resends_everything()
+{
+    frame.invalidate();
+    TEST_ASSERT_EQUAL_size_t( 8 * ( 1 + 8 ) + rows * ( 1 + columns ), frame.flush( &panel ) );
+    TEST_ASSERT_EQUAL_size_t( 0, frame.flush( &panel ) );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_first_flush_sends_every_cell_and_glyph );
+    RUN_TEST( test_unchanged_rows_send_nothing );
+    RUN_TEST( test_changed_value_sends_its_cells );
+    RUN_TEST( test_shared_glyph_is_defined_once );
+    RUN_TEST( test_evicted_glyph_is_redefined_in_place );
+    RUN_TEST( test_invalidate_resends_everything );
+    return UNITY_END();
+}
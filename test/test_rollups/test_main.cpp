@@ -0,0 +1,337 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+#include <DatabaseQueries.hpp>
+
+// Merges samples into a rollup table the way Database::accumulate() binds them, on an in-memory SQLite of the host
+
+static constexpr auto hourly{"SENSORS_DATA_HOURLY"};
+
+static sqlite3* db{};
+
+struct Aggregate
+{
+    double min;
+    double max;
+    double sum;
+    int64_t count;
+};
+
+static auto execute( const std::string& query ) -> void
+{
+    char* error{};
+    if ( sqlite3_exec( db, query.data(), nullptr, nullptr, &error ) != SQLITE_OK )
+    {
+        TEST_FAIL_MESSAGE( error );
+    }
+}
+
+static auto prepare( const std::string& query ) -> sqlite3_stmt*
+{
+    sqlite3_stmt* res{};
+    if ( sqlite3_prepare_v2( db, query.data(), query.size(), &res, nullptr ) != SQLITE_OK )
+    {
+        TEST_FAIL_MESSAGE( sqlite3_errmsg( db ) );
+    }
+    return res;
+}
+
+static auto createTables( size_t sensorCount ) -> void
+{
+    execute( DatabaseQueries::table );
+    for ( size_t n{0}; n < sensorCount; ++n )
+    {
+        execute( DatabaseQueries::addColumn( "SENSORS_DATA", DatabaseQueries::sensorColumn( n ) ) );
+    }
+    execute( DatabaseQueries::rollupTable( hourly ) );
+    for ( const auto& column : DatabaseQueries::rollupAggregates( DatabaseQueries::rollupColumns( sensorCount ) ) )
+    {
+        execute( DatabaseQueries::addColumn( hourly, column ) );
+    }
+}
+
+static auto single( double value ) -> Aggregate
+{
+    return Aggregate{value, value, value, std::isnan( value ) ? 0 : 1};
+}
+
+static auto merge( sqlite3_stmt* create, sqlite3_stmt* merge, int64_t period, int64_t count, const std::vector<Aggregate>& aggregates ) -> void
+{
+    sqlite3_bind_int64( create, 1, period );
+    TEST_ASSERT_EQUAL( SQLITE_DONE, sqlite3_step( create ) );
+    sqlite3_reset( create );
+
+    sqlite3_bind_int64( merge, 1, period );
+    sqlite3_bind_int64( merge, 2, count );
+    for ( size_t n{0}; n < aggregates.size(); ++n )
+    {
+        sqlite3_bind_double( merge, 3 + n * 4, aggregates[n].min );
+        sqlite3_bind_double( merge, 4 + n * 4, aggregates[n].max );
+        sqlite3_bind_double( merge, 5 + n * 4, aggregates[n].sum );
+        sqlite3_bind_int64( merge, 6 + n * 4, aggregates[n].count );
+    }
+    TEST_ASSERT_EQUAL( SQLITE_DONE, sqlite3_step( merge ) );
+    sqlite3_reset( merge );
+}
+
+static auto insert( sqlite3_stmt* res, int64_t dateTime, const std::vector<double>& values ) -> void
+{
+    sqlite3_bind_int64( res, 1, dateTime );
+    for ( size_t n{0}; n < values.size(); ++n )
+    {
+        sqlite3_bind_double( res, 2 + n, values[n] );
+    }
+    TEST_ASSERT_EQUAL( SQLITE_DONE, sqlite3_step( res ) );
+    sqlite3_reset( res );
+}
+
+// Reads the rollup of period and returns its per column aggregates
+static auto read( int64_t period, size_t columns, int64_t* count ) -> std::vector<Aggregate>
+{
+    const auto res{prepare( DatabaseQueries::rollupSelect( hourly, DatabaseQueries::rollupColumns( columns - 3 ) ) )};
+    sqlite3_bind_int64( res, 1, period );
+    sqlite3_bind_int64( res, 2, period );
+    auto aggregates{std::vector<Aggregate>{}};
+    if ( sqlite3_step( res ) == SQLITE_ROW )
+    {
+        *count = sqlite3_column_int64( res, 1 );
+        for ( size_t n{0}; n < columns; ++n )
+        {
+            const auto column{static_cast<int>( 2 + n * 4 )};
+            aggregates.push_back( Aggregate{sqlite3_column_double( res, column ), sqlite3_column_double( res, column + 1 ), sqlite3_column_double( res, column + 2 ), sqlite3_column_int64( res, column + 3 )} );
+        }
+    }
+    sqlite3_finalize( res );
+    return aggregates;
+}
+
+void setUp()
+{
+    sqlite3_open( ":memory:", &db );
+}
+
+void tearDown()
+{
+    sqlite3_close( db );
+    db = nullptr;
+}
+
+static void test_average_ignores_null_samples()
+{
+    createTables( 1 );
+    const auto columns{DatabaseQueries::rollupColumns( 1 )};
+    const auto create{prepare( DatabaseQueries::rollupCreate( hourly ) )};
+    const auto update{prepare( DatabaseQueries::rollupMerge( hourly, columns ) )};
+
+    // SENSOR_1 only reads during the second half of the hour
+    for ( auto n{0}; n < 12; ++n )
+    {
+        merge( create, update, 3600, 1, {single( 20 ), single( 50 ), single( 1000 ), single( n < 6 ? NAN : 10.0 * n )} );
+    }
+    sqlite3_finalize( create );
+    sqlite3_finalize( update );
+
+    auto count{int64_t{0}};
+    const auto aggregates{read( 3600, 4, &count )};
+    TEST_ASSERT_EQUAL_INT64( 12, count );
+    TEST_ASSERT_EQUAL_INT64( 12, aggregates[0].count );
+    TEST_ASSERT_EQUAL_DOUBLE( 20, aggregates[0].sum / aggregates[0].count );
+    TEST_ASSERT_EQUAL_INT64( 6, aggregates[3].count );
+    TEST_ASSERT_EQUAL_DOUBLE( 60, aggregates[3].min );
+    TEST_ASSERT_EQUAL_DOUBLE( 110, aggregates[3].max );
+    TEST_ASSERT_EQUAL_DOUBLE( 85, aggregates[3].sum / aggregates[3].count );
+}
+
+static void test_backfill_matches_incremental()
+{
+    createTables( 1 );
+    const auto columns{DatabaseQueries::rollupColumns( 1 )};
+
+    const auto res{prepare( DatabaseQueries::insert( 1 ) )};
+    for ( auto n{0}; n < 24; ++n )
+    {
+        insert( res, 3600 + n * 300, {20.0 + n, 50, 1000, n % 3 == 0 ? NAN : n} );
+    }
+    sqlite3_finalize( res );
+
+    const auto backfill{prepare( DatabaseQueries::rollupBackfill( columns ) )};
+    const auto create{prepare( DatabaseQueries::rollupCreate( hourly ) )};
+    const auto update{prepare( DatabaseQueries::rollupMerge( hourly, columns ) )};
+    sqlite3_bind_int64( backfill, 1, 0 );
+    sqlite3_bind_int64( backfill, 2, 24 );
+    sqlite3_bind_int64( backfill, 3, 3600 );
+    while ( sqlite3_step( backfill ) == SQLITE_ROW )
+    {
+        auto aggregates{std::vector<Aggregate>{}};
+        for ( size_t n{0}; n < columns.size(); ++n )
+        {
+            const auto column{static_cast<int>( 2 + n * 4 )};
+            const auto min{sqlite3_column_type( backfill, column ) == SQLITE_NULL ? NAN : sqlite3_column_double( backfill, column )};
+            const auto max{sqlite3_column_type( backfill, column + 1 ) == SQLITE_NULL ? NAN : sqlite3_column_double( backfill, column + 1 )};
+            aggregates.push_back( Aggregate{min, max, sqlite3_column_double( backfill, column + 2 ), sqlite3_column_int64( backfill, column + 3 )} );
+        }
+        const auto dateTime{sqlite3_column_int64( backfill, 0 )};
+        merge( create, update, dateTime - dateTime % 3600, sqlite3_column_int64( backfill, 1 ), aggregates );
+    }
+    sqlite3_finalize( backfill );
+    sqlite3_finalize( create );
+    sqlite3_finalize( update );
+
+    auto count{int64_t{0}};
+    const auto first{read( 3600, 4, &count )};
+    TEST_ASSERT_EQUAL_INT64( 12, count );
+    TEST_ASSERT_EQUAL_INT64( 8, first[3].count );
+    // Sensor readings 1, 2, 4, 5, 7, 8, 10, 11
+    TEST_ASSERT_EQUAL_DOUBLE( 48.0 / 8, first[3].sum / first[3].count );
+    TEST_ASSERT_EQUAL_DOUBLE( 25.5, first[0].sum / first[0].count );
+
+    const auto second{read( 7200, 4, &count )};
+    TEST_ASSERT_EQUAL_INT64( 12, count );
+    TEST_ASSERT_EQUAL_INT64( 8, second[3].count );
+}
+
+static void test_counts_filled_for_rollups_written_before()
+{
+    // A revision 1 table: no _COUNT columns
+    execute( DatabaseQueries::rollupTable( hourly ) );
+    const auto columns{DatabaseQueries::rollupColumns( 2 )};
+    for ( const auto& column : columns )
+    {
+        execute( DatabaseQueries::addColumn( hourly, column + "_MIN" ) );
+        execute( DatabaseQueries::addColumn( hourly, column + "_MAX" ) );
+        execute( DatabaseQueries::addColumn( hourly, column + "_SUM" ) );
+    }
+    // SENSOR_2 was never read in that hour
+    execute( std::string{"INSERT INTO "} + hourly + " ( PERIOD, COUNT, TEMPERATURE_MIN, TEMPERATURE_MAX, TEMPERATURE_SUM, SENSOR_1_MIN, SENSOR_1_MAX, SENSOR_1_SUM, SENSOR_2_SUM ) "
+             "VALUES ( 3600, 12, 19, 21, 240, 5, 7, 72, 0 )" );
+
+    for ( const auto& column : DatabaseQueries::rollupAggregates( columns ) )
+    {
+        if ( column.find( "_COUNT" ) != std::string::npos )
+        {
+            execute( DatabaseQueries::addColumn( hourly, column ) );
+        }
+    }
+    execute( DatabaseQueries::rollupCounts( hourly, columns ) );
+
+    auto count{int64_t{0}};
+    const auto aggregates{read( 3600, 5, &count )};
+    TEST_ASSERT_EQUAL_INT64( 12, aggregates[0].count );
+    TEST_ASSERT_EQUAL_INT64( 0, aggregates[1].count );
+    TEST_ASSERT_EQUAL_INT64( 12, aggregates[3].count );
+    TEST_ASSERT_EQUAL_INT64( 0, aggregates[4].count );
+
+    // Running it again, as every schema change does, keeps the counts merged since
+    execute( std::string{"UPDATE "} + hourly + " SET SENSOR_2_COUNT = 3" );
+    execute( DatabaseQueries::rollupCounts( hourly, columns ) );
+    TEST_ASSERT_EQUAL_INT64( 3, read( 3600, 5, &count )[4].count );
+}
+
+struct Cost
+{
+    double microseconds;
+    double bytes;
+};
+
+// One week of 5 minute samples stored and merged into the hourly and daily rollups, 12 samples per transaction
+static auto measure( size_t sensorCount ) -> Cost
+{
+    static constexpr auto samples{7 * 288};
+    static constexpr auto daily{"SENSORS_DATA_DAILY"};
+
+    createTables( sensorCount );
+    execute( DatabaseQueries::rollupTable( daily ) );
+    const auto columns{DatabaseQueries::rollupColumns( sensorCount )};
+    for ( const auto& column : DatabaseQueries::rollupAggregates( columns ) )
+    {
+        execute( DatabaseQueries::addColumn( daily, column ) );
+    }
+
+    const auto res{prepare( DatabaseQueries::insert( sensorCount ) )};
+    const auto createHourly{prepare( DatabaseQueries::rollupCreate( hourly ) )};
+    const auto mergeHourly{prepare( DatabaseQueries::rollupMerge( hourly, columns ) )};
+    const auto createDaily{prepare( DatabaseQueries::rollupCreate( daily ) )};
+    const auto mergeDaily{prepare( DatabaseQueries::rollupMerge( daily, columns ) )};
+
+    auto values{std::vector<double>( columns.size() )};
+    auto aggregates{std::vector<Aggregate>( columns.size() )};
+    const auto begin{std::chrono::steady_clock::now()};
+    for ( auto n{0}; n < samples; ++n )
+    {
+        if ( n % 12 == 0 )
+        {
+            execute( "BEGIN TRANSACTION" );
+        }
+        const auto dateTime{int64_t{n} * 300};
+        for ( size_t column{0}; column < columns.size(); ++column )
+        {
+            values[column] = ( n * 7 + column * 13 ) % 1000 / 10.0;
+            aggregates[column] = single( values[column] );
+        }
+        insert( res, dateTime, values );
+        merge( createHourly, mergeHourly, dateTime - dateTime % 3600, 1, aggregates );
+        merge( createDaily, mergeDaily, dateTime - dateTime % 86400, 1, aggregates );
+        if ( n % 12 == 11 )
+        {
+            execute( "COMMIT TRANSACTION" );
+        }
+    }
+    const auto elapsed{std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - begin ).count()};
+
+    for ( const auto statement : {res, createHourly, mergeHourly, createDaily, mergeDaily} )
+    {
+        sqlite3_finalize( statement );
+    }
+
+    auto pages{int64_t{0}};
+    auto pageSize{int64_t{0}};
+    {
+        const auto pragma{prepare( "SELECT page_count, page_size FROM pragma_page_count, pragma_page_size" )};
+        if ( sqlite3_step( pragma ) == SQLITE_ROW )
+        {
+            pages = sqlite3_column_int64( pragma, 0 );
+            pageSize = sqlite3_column_int64( pragma, 1 );
+        }
+        sqlite3_finalize( pragma );
+    }
+
+    // Next size on a fresh database
+    sqlite3_close( db );
+    sqlite3_open( ":memory:", &db );
+
+    return Cost{elapsed / samples, static_cast<double>( pages * pageSize ) / samples};
+}
+
+static void test_benchmark_channels()
+{
+    auto costs{std::vector<Cost>{}};
+    for ( const auto sensorCount : {size_t{3}, size_t{16}, size_t{64}} )
+    {
+        const auto cost{measure( sensorCount )};
+        char message[160];
+        std::snprintf( message, sizeof( message ), "%2u sensors: %.1f us and %.0f bytes per sample, %.2f us per column",
+                       static_cast<unsigned>( sensorCount ), cost.microseconds, cost.bytes, cost.microseconds / ( sensorCount + 3 ) );
+        TEST_MESSAGE( message );
+        costs.push_back( cost );
+    }
+
+    // Linear: a column costs no more with 64 sensors than with 16, with a wide margin for a noisy host
+    TEST_ASSERT_LESS_THAN( 2 * costs[1].microseconds / 19, costs[2].microseconds / 67 );
+    TEST_ASSERT_LESS_THAN( 2 * costs[1].bytes / 19, costs[2].bytes / 67 );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_average_ignores_null_samples );
+    RUN_TEST( test_backfill_matches_incremental );
+    RUN_TEST( test_counts_filled_for_rollups_written_before );
+    RUN_TEST( test_benchmark_channels );
+    return UNITY_END();
+}
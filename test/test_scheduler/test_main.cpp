@@ -0,0 +1,193 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <Scheduler.hpp>
+
+// The scheduler keeps its tasks in statics, every test cancels what it added in tearDown()
+
+static auto runs{std::array<int, 4> {}};
+static auto order{std::array<int, 8> {}};
+static auto ordered{size_t{0}};
+
+static auto record( int task ) -> void
+{
+    runs[task]++;
+    if ( ordered < order.size() )
+    {
+        order[ordered++] = task;
+    }
+}
+
+static auto first() -> void
+{
+    record( 0 );
+}
+
+static auto second() -> void
+{
+    record( 1 );
+}
+
+static auto slow() -> void
+{
+    record( 2 );
+    // Takes longer than its own interval
+    Host::advance( 250000 );
+}
+
+static auto retiring() -> void
+{
+    record( 3 );
+    if ( runs[3] == 3 )
+    {
+        Scheduler::cancel( retiring );
+    }
+}
+
+static auto at( int64_t ms ) -> void
+{
+    Host::clock() = ms * 1000;
+    Scheduler::process();
+}
+
+void setUp()
+{
+    Host::clock() = 0;
+    runs.fill( 0 );
+    order.fill( -1 );
+    ordered = 0;
+}
+
+void tearDown()
+{
+    for ( auto n{0}; n < 16; ++n )
+    {
+        Scheduler::cancel( first );
+        Scheduler::cancel( second );
+        Scheduler::cancel( slow );
+        Scheduler::cancel( retiring );
+    }
+}
+
+static void test_periodic_runs_now_and_every_interval()
+{
+    Scheduler::periodic( std::chrono::milliseconds( 100 ), first );
+    at( 0 );
+    TEST_ASSERT_EQUAL( 1, runs[0] );
+    at( 99 );
+    TEST_ASSERT_EQUAL( 1, runs[0] );
+    at( 100 );
+    TEST_ASSERT_EQUAL( 2, runs[0] );
+    // A late run is not caught up, the next one comes an interval after it
+    at( 350 );
+    TEST_ASSERT_EQUAL( 3, runs[0] );
+    at( 400 );
+    TEST_ASSERT_EQUAL( 3, runs[0] );
+    at( 450 );
+    TEST_ASSERT_EQUAL( 4, runs[0] );
+}
+
+static void test_overrun_skips_missed_runs()
+{
+    Scheduler::periodic( std::chrono::milliseconds( 100 ), slow );
+    at( 0 );
+    TEST_ASSERT_EQUAL( 1, runs[2] );
+    TEST_ASSERT_EQUAL_INT64( 250000, esp_timer_get_time() );
+    // The missed deadlines at 100 and 200 ms collapse into one run an interval after the overrun
+    at( 300 );
+    TEST_ASSERT_EQUAL( 1, runs[2] );
+    at( 350 );
+    TEST_ASSERT_EQUAL( 2, runs[2] );
+}
+
+static void test_earliest_deadline_first()
+{
+    Scheduler::periodic( std::chrono::milliseconds( 300 ), first );
+    Scheduler::periodic( std::chrono::milliseconds( 200 ), second );
+    at( 0 );
+    at( 200 );
+    at( 300 );
+    at( 400 );
+    TEST_ASSERT_EQUAL( 2, runs[0] );
+    TEST_ASSERT_EQUAL( 3, runs[1] );
+    TEST_ASSERT_EQUAL( 1, order[2] );
+    TEST_ASSERT_EQUAL( 0, order[3] );
+    TEST_ASSERT_EQUAL( 1, order[4] );
+}
+
+static void test_until_next()
+{
+    TEST_ASSERT_TRUE( Scheduler::untilNext() == std::chrono::microseconds::max() );
+    Scheduler::periodic( std::chrono::milliseconds( 100 ), first );
+    Scheduler::periodic( std::chrono::milliseconds( 30 ), second );
+    at( 0 );
+    TEST_ASSERT_EQUAL_INT64( 30000, Scheduler::untilNext().count() );
+    Host::clock() = 45000;
+    TEST_ASSERT_EQUAL_INT64( 0, Scheduler::untilNext().count() );
+}
+
+static void test_bound_waits_for_wall_clock_multiple()
+{
+    Scheduler::bound( std::chrono::minutes( 1 ), first );
+    const auto wait{Scheduler::untilNext()};
+    TEST_ASSERT_TRUE( wait > std::chrono::microseconds::zero() );
+    TEST_ASSERT_TRUE( wait <= std::chrono::minutes( 1 ) );
+    at( 0 );
+    TEST_ASSERT_EQUAL( 0, runs[0] );
+}
+
+static void test_cancel()
+{
+    Scheduler::periodic( std::chrono::milliseconds( 100 ), first );
+    Scheduler::periodic( std::chrono::milliseconds( 100 ), second );
+    at( 0 );
+    Scheduler::cancel( first );
+    at( 100 );
+    at( 200 );
+    TEST_ASSERT_EQUAL( 1, runs[0] );
+    TEST_ASSERT_EQUAL( 3, runs[1] );
+
+    // Unknown functions are ignored
+    Scheduler::cancel( slow );
+    at( 300 );
+    TEST_ASSERT_EQUAL( 4, runs[1] );
+}
+
+static void test_task_retires_itself()
+{
+    Scheduler::periodic( std::chrono::milliseconds( 10 ), retiring );
+    Scheduler::periodic( std::chrono::milliseconds( 10 ), first );
+    for ( auto ms{0}; ms <= 100; ms += 10 )
+    {
+        at( ms );
+    }
+    TEST_ASSERT_EQUAL( 3, runs[3] );
+    TEST_ASSERT_EQUAL( 11, runs[0] );
+}
+
+static void test_cancelled_slots_are_reused()
+{
+    for ( auto n{0}; n < 16; ++n )
+    {
+        Scheduler::periodic( std::chrono::milliseconds( 100 ), first );
+    }
+    Scheduler::cancel( first );
+    Scheduler::periodic( std::chrono::milliseconds( 100 ), second );
+    at( 0 );
+    TEST_ASSERT_EQUAL( 15, runs[0] );
+    TEST_ASSERT_EQUAL( 1, runs[1] );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_periodic_runs_now_and_every_interval );
+    RUN_TEST( test_overrun_skips_missed_runs );
+    RUN_TEST( test_earliest_deadline_first );
+    RUN_TEST( test_until_next );
+    RUN_TEST( test_bound_waits_for_wall_clock_multiple );
+    RUN_TEST( test_cancel );
+    RUN_TEST( test_task_retires_itself );
+    RUN_TEST( test_cancelled_slots_are_reused );
+    return UNITY_END();
+}
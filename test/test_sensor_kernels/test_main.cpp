@@ -0,0 +1,200 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <Arduino.h>
+#include <SensorKernels.hpp>
+#include <SensorModels.hpp>
+
+// Checks the fixed point kernels of Infos against the double arithmetic they replaced. On the host the benchmark
+// reports nanoseconds, on the board ( pio test -e esp32doit-devkit-v1 ) it reports CPU cycles.
+
+static constexpr uint8_t oversamplingBits{4};
+static constexpr uint32_t countsMax{( 4095 << oversamplingBits ) + ( 1 << oversamplingBits ) - 1};
+
+struct Calibration
+{
+    double angularCoefficient;
+    double linearCoefficient;
+};
+
+// Full scale of the ADC as the supply of the sensor, then dividers off by a few percent either way
+static const Calibration calibrations[]
+{
+    {1.0 / 4095, 0.0},
+    {1.03 / 4095, -0.012},
+    {0.97 / 4095, 0.02},
+    {1.1 / 4095, 0.1},
+};
+
+// The per sample arithmetic as Infos had it before the fixed point kernels
+template<typename Model>
+static auto reference( const Calibration& calibration, uint32_t counts ) -> double
+{
+    const auto rawRead{static_cast<double>( counts ) / ( 1 << oversamplingBits )};
+    const auto calibratedRead{rawRead * calibration.angularCoefficient + calibration.linearCoefficient};
+    const auto sensorValue{( calibratedRead + Model::zeroOffset ) / Model::sensitivity};
+    return std::min( std::max( sensorValue, 0.0 ), Model::max );
+}
+
+static auto now() -> uint32_t
+{
+#ifdef ARDUINO
+    return ESP.getCycleCount();
+#else
+    return static_cast<uint32_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+}
+
+#ifdef ARDUINO
+static constexpr auto unit{"cycles"};
+static constexpr uint32_t benchmarkSamples{4096};
+#else
+static constexpr auto unit{"ns"};
+static constexpr uint32_t benchmarkSamples{1 << 20};
+#endif
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+template<typename Model>
+static auto checkModel() -> void
+{
+    for ( const auto& calibration : calibrations )
+    {
+        const auto map{SensorKernels::calibrate<Model>( calibration.angularCoefficient, calibration.linearCoefficient, oversamplingBits )};
+        auto worst{0.0};
+        for ( uint32_t counts{0}; counts <= countsMax; ++counts )
+        {
+            const auto expected{reference<Model>( calibration, counts ) * 100};
+            const auto centi{SensorKernels::convert<Model>( map, counts )};
+            worst = std::max( worst, std::fabs( centi - expected ) );
+        }
+        char message[120];
+        std::snprintf( message, sizeof( message ), "max %.0f kPa, angular %.3g: worst error %.3f LSB", Model::max, calibration.angularCoefficient * 4095, worst );
+        TEST_MESSAGE( message );
+        // Half an LSB from the rounding, the rest from the Q24 gain
+        TEST_ASSERT_TRUE_MESSAGE( worst <= 1.0, message );
+    }
+}
+
+static void test_convert_within_one_lsb()
+{
+    checkModel<SensorModels::MPX5050>();
+    checkModel<SensorModels::MPX5100>();
+    checkModel<SensorModels::MPX5500>();
+    checkModel<SensorModels::MPX5700>();
+}
+
+static void test_invert_round_trip()
+{
+    const auto map{SensorKernels::calibrate<SensorModels::MPX5100>( 1.0 / 4095, 0.0, oversamplingBits )};
+    for ( int32_t centi{1000}; centi <= 9000; centi += 7 )
+    {
+        const auto counts{SensorKernels::invert( map, centi )};
+        TEST_ASSERT_INT_WITHIN( 1, centi, SensorKernels::convert<SensorModels::MPX5100>( map, counts ) );
+    }
+    TEST_ASSERT_EQUAL_UINT32( 0, SensorKernels::invert( SensorKernels::Map{0, 0}, 5000 ) );
+}
+
+static void test_filter_within_one_lsb()
+{
+    auto random{std::mt19937{7}};
+    auto noise{std::normal_distribution<double>{0.0, 40.0}};
+    // Internal sampling at 10 Hz and an external converter every 8 s over the 10 minutes update period
+    for ( const auto samples : {6000.0, 75.0} )
+    {
+        auto ema{SensorKernels::Ema{SensorKernels::weight( samples ), 0, false}};
+        const auto factor{2.0 / ( samples + 1.0 )};
+        auto filtered{0.0};
+        auto worst{0.0};
+        for ( auto n{0}; n < 200000; ++n )
+        {
+            // A level swinging through the whole range of an MPX5700 with noise on top
+            const auto centi{static_cast<int32_t>( std::min( std::max( 35000 + 34000 * std::sin( n / 5000.0 ) + noise( random ), 0.0 ), 70000.0 ) )};
+            filtered = n == 0 ? centi : factor * centi + ( 1.0 - factor ) * filtered;
+            worst = std::max( worst, std::fabs( SensorKernels::filter( &ema, centi ) - filtered ) );
+        }
+        char message[80];
+        std::snprintf( message, sizeof( message ), "EMA over %.0f samples: worst error %.3f LSB", samples, worst );
+        TEST_MESSAGE( message );
+        TEST_ASSERT_TRUE_MESSAGE( worst <= 1.0, message );
+    }
+}
+
+static void test_benchmark_cycles_per_sample()
+{
+    const Calibration calibration{1.03 / 4095, -0.012};
+    const auto map{SensorKernels::calibrate<SensorModels::MPX5700>( calibration.angularCoefficient, calibration.linearCoefficient, oversamplingBits )};
+    auto ema{SensorKernels::Ema{SensorKernels::weight( 6000 ), 0, false}};
+    const auto factor{2.0 / 6001.0};
+
+    // Counts are generated outside the timed loops so both pay only for the arithmetic
+    auto counts{std::vector<uint32_t>( benchmarkSamples )};
+    for ( uint32_t n{0}; n < benchmarkSamples; ++n )
+    {
+        counts[n] = ( n * 2654435761u ) % ( countsMax + 1 );
+    }
+
+    volatile int32_t fixedSink{};
+    auto begin{now()};
+    for ( const auto sample : counts )
+    {
+        fixedSink = SensorKernels::filter( &ema, SensorKernels::convert<SensorModels::MPX5700>( map, sample ) );
+    }
+    const auto fixed{now() - begin};
+
+    volatile double doubleSink{};
+    auto filtered{0.0};
+    begin = now();
+    for ( const auto sample : counts )
+    {
+        filtered = factor * reference<SensorModels::MPX5700>( calibration, sample ) + ( 1.0 - factor ) * filtered;
+        doubleSink = filtered;
+    }
+    const auto floating{now() - begin};
+
+    char message[120];
+    std::snprintf( message, sizeof( message ), "convert and filter per sample: fixed point %.2f %s, double %.2f %s",
+                   static_cast<double>( fixed ) / benchmarkSamples, unit, static_cast<double>( floating ) / benchmarkSamples, unit );
+    TEST_MESSAGE( message );
+    ( void )fixedSink;
+    ( void )doubleSink;
+}
+
+static auto run() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_convert_within_one_lsb );
+    RUN_TEST( test_invert_round_trip );
+    RUN_TEST( test_filter_within_one_lsb );
+    RUN_TEST( test_benchmark_cycles_per_sample );
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    // Leaves the serial monitor time to attach
+    delay( 2000 );
+    run();
+}
+
+void loop()
+{
+}
+#else
+auto main() -> int
+{
+    return run();
+}
+#endif
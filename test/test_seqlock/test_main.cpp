@@ -0,0 +1,118 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <SeqLock.hpp>
+
+// One writer storing snapshots whose fields all carry the same sequence number, reader threads checking every
+// snapshot they load is whole and never older than the previous one
+
+static constexpr size_t readers{4};
+static constexpr uint32_t stores{3000000};
+
+// Larger than a cache line so a torn copy spans several of them, like Infos::Snapshot with many sensors
+struct Sample
+{
+    uint32_t fields[40];
+};
+
+static auto make( uint32_t sequence ) -> Sample
+{
+    auto sample{Sample{}};
+    for ( auto& field : sample.fields )
+    {
+        field = sequence;
+    }
+    return sample;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_load_returns_last_store()
+{
+    SeqLock<Sample> lock{};
+    TEST_ASSERT_EQUAL_UINT32( 0, lock.load().fields[0] );
+    lock.store( make( 7 ) );
+    lock.store( make( 8 ) );
+    const auto sample{lock.load()};
+    TEST_ASSERT_EQUAL_UINT32( 8, sample.fields[0] );
+    TEST_ASSERT_EQUAL_UINT32( 8, sample.fields[39] );
+}
+
+static void test_stress_readers_never_see_torn_snapshots()
+{
+    SeqLock<Sample> lock{};
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> backwards{0};
+    std::atomic<uint64_t> loads{0};
+
+    auto threads{std::vector<std::thread>{}};
+    for ( size_t n{0}; n < readers; ++n )
+    {
+        threads.emplace_back( [&]()
+        {
+            auto previous{uint32_t{0}};
+            auto count{uint64_t{0}};
+            while ( not done.load( std::memory_order_relaxed ) )
+            {
+                const auto sample{lock.load()};
+                for ( const auto field : sample.fields )
+                {
+                    if ( field != sample.fields[0] )
+                    {
+                        torn++;
+                        break;
+                    }
+                }
+                if ( sample.fields[0] < previous )
+                {
+                    backwards++;
+                }
+                previous = sample.fields[0];
+                count++;
+            }
+            loads += count;
+        } );
+    }
+
+    const auto begin{std::chrono::steady_clock::now()};
+    for ( uint32_t sequence{1}; sequence <= stores; ++sequence )
+    {
+        lock.store( make( sequence ) );
+    }
+    const auto elapsed{std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count()};
+    done = true;
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    char message[160];
+    std::snprintf( message, sizeof( message ), "%u stores against %u readers in %.2f s, %llu loads: %llu torn, %llu out of order",
+                   static_cast<unsigned>( stores ), static_cast<unsigned>( readers ), elapsed, static_cast<unsigned long long>( loads.load() ),
+                   static_cast<unsigned long long>( torn.load() ), static_cast<unsigned long long>( backwards.load() ) );
+    TEST_MESSAGE( message );
+
+    TEST_ASSERT_EQUAL_UINT64( 0, torn.load() );
+    TEST_ASSERT_EQUAL_UINT64( 0, backwards.load() );
+    TEST_ASSERT_EQUAL_UINT32( stores, lock.load().fields[0] );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_load_returns_last_store );
+    RUN_TEST( test_stress_readers_never_see_torn_snapshots );
+    return UNITY_END();
+}
@@ -0,0 +1,271 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <sqlite3.h>
+#include <vector>
+
+#include <DatabaseQueries.hpp>
+#include <TimeSeriesCodec.hpp>
+
+// Runs the compressed engine codec on blocks kept in memory and compares it with SENSORS_DATA in an in-memory SQLite.
+// Neither side pays for the SD card here, the numbers are the CPU and space cost of each format.
+
+static constexpr size_t sensorCount{3};
+static constexpr uint16_t columns{3 + sensorCount};
+static constexpr int64_t sampleInterval{300};
+static constexpr int64_t year{365 * 288};
+
+struct Sample
+{
+    int64_t time;
+    std::array<uint64_t, TimeSeries::valuesMax> values;
+};
+
+// Blocks filled the way TimeSeries::append() fills them, without the file
+class Store
+{
+    public:
+        auto append( const Sample& sample, uint16_t sampleColumns ) -> void
+        {
+            if ( this->state.count > 0 and ( this->state.position + TimeSeries::sampleMaxBits( sampleColumns ) > TimeSeries::payloadBits or this->current.header.columns != sampleColumns ) )
+            {
+                this->blocks.push_back( this->current );
+                this->current = TimeSeries::Block{};
+                this->state = TimeSeries::State{};
+            }
+            if ( this->state.count == 0 )
+            {
+                this->current.header.firstId = this->nextId;
+                this->current.header.columns = sampleColumns;
+            }
+            TimeSeries::encode( &this->current, &this->state, sample.time, sample.values );
+            this->nextId++;
+        }
+
+        auto close() -> void
+        {
+            if ( this->state.count > 0 )
+            {
+                this->blocks.push_back( this->current );
+                this->state = TimeSeries::State{};
+            }
+        }
+
+        std::vector<TimeSeries::Block> blocks{};
+
+    private:
+        TimeSeries::Block current{};
+        TimeSeries::State state{};
+        int64_t nextId{1};
+};
+
+// A year of 5 minute samples at the resolution of the sensors: 0.01 °C, 1/1024 %RH, 0.01 hPa,
+// and levels converted from slowly drifting 16x oversampled ADC counts
+static auto generate( int64_t count ) -> std::vector<Sample>
+{
+    auto random{std::mt19937{42}};
+    auto noise{std::uniform_int_distribution<int>{-2, 2}};
+    auto counts{std::array<int, sensorCount> {20000, 35000, 50000}};
+
+    auto samples{std::vector<Sample>( count )};
+    for ( int64_t n{0}; n < count; ++n )
+    {
+        const auto day{2 * M_PI * n / 288};
+        auto& sample{samples[n]};
+        sample.time = 1600000000 + n * sampleInterval;
+        sample.values[0] = TimeSeries::toBits( std::round( ( 20 + 5 * std::sin( day ) ) * 100 + noise( random ) ) / 100 );
+        sample.values[1] = TimeSeries::toBits( std::round( ( 55 + 10 * std::cos( day ) ) * 1024 + noise( random ) ) / 1024 );
+        sample.values[2] = TimeSeries::toBits( std::round( 101325 + 300 * std::sin( day / 7 ) + noise( random ) ) / 100 );
+        for ( size_t s{0}; s < sensorCount; ++s )
+        {
+            counts[s] += noise( random );
+            sample.values[3 + s] = TimeSeries::toBits( counts[s] * 0.0015625 - 5.0 );
+        }
+    }
+    return samples;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_round_trip_is_bit_exact()
+{
+    auto samples{generate( 2000 )};
+    // Clock set back and forth, a missing sample and sensors without a reading
+    samples[500].time -= 3600;
+    samples[900].time += 86400 * 30;
+    for ( auto n{1000}; n < 1100; ++n )
+    {
+        samples[n].values[4] = TimeSeries::toBits( NAN );
+    }
+    samples.erase( samples.begin() + 1500 );
+
+    auto store{Store{}};
+    for ( const auto& sample : samples )
+    {
+        store.append( sample, columns );
+    }
+    store.close();
+
+    size_t n{0};
+    auto firstId{int64_t{1}};
+    for ( const auto& block : store.blocks )
+    {
+        TEST_ASSERT_EQUAL_UINT32( TimeSeries::magic, block.header.magic );
+        TEST_ASSERT_EQUAL_INT64( firstId, block.header.firstId );
+        TEST_ASSERT_LESS_OR_EQUAL( TimeSeries::payloadBits, block.header.bits );
+        auto state{TimeSeries::State{}};
+        for ( uint16_t sample{0}; sample < block.header.count; ++sample, ++n )
+        {
+            TimeSeries::decode( block, &state );
+            TEST_ASSERT_EQUAL_INT64( samples[n].time, state.time );
+            TEST_ASSERT_EQUAL_MEMORY( samples[n].values.data(), state.values.data(), columns * sizeof( uint64_t ) );
+        }
+        TEST_ASSERT_EQUAL_UINT16( block.header.bits, state.position );
+        firstId += block.header.count;
+    }
+    TEST_ASSERT_EQUAL_size_t( samples.size(), n );
+}
+
+static void test_sensor_count_change_closes_block()
+{
+    const auto samples{generate( 20 )};
+    auto store{Store{}};
+    for ( size_t n{0}; n < samples.size(); ++n )
+    {
+        store.append( samples[n], n < 10 ? columns : columns - 1 );
+    }
+    store.close();
+
+    TEST_ASSERT_EQUAL_size_t( 2, store.blocks.size() );
+    TEST_ASSERT_EQUAL_UINT16( columns, store.blocks[0].header.columns );
+    TEST_ASSERT_EQUAL_UINT16( columns - 1, store.blocks[1].header.columns );
+    TEST_ASSERT_EQUAL_INT64( 11, store.blocks[1].header.firstId );
+}
+
+static void test_benchmark_against_sqlite()
+{
+    const auto samples{generate( year )};
+
+    // Compressed engine
+    auto store{Store{}};
+    auto begin{std::chrono::steady_clock::now()};
+    for ( const auto& sample : samples )
+    {
+        store.append( sample, columns );
+    }
+    store.close();
+    const auto encodeTime{std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - begin ).count()};
+
+    begin = std::chrono::steady_clock::now();
+    auto decoded{size_t{0}};
+    auto checksum{uint64_t{0}};
+    for ( const auto& block : store.blocks )
+    {
+        auto state{TimeSeries::State{}};
+        for ( uint16_t sample{0}; sample < block.header.count; ++sample )
+        {
+            TimeSeries::decode( block, &state );
+            checksum ^= state.values[3];
+            decoded++;
+        }
+    }
+    const auto decodeTime{std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count()};
+    TEST_ASSERT_EQUAL_size_t( samples.size(), decoded );
+
+    // SQLite, batches of 12 as the storage task commits them
+    sqlite3* db{};
+    sqlite3_open( ":memory:", &db );
+    sqlite3_exec( db, DatabaseQueries::table, nullptr, nullptr, nullptr );
+    for ( size_t n{0}; n < sensorCount; ++n )
+    {
+        sqlite3_exec( db, DatabaseQueries::addColumn( "SENSORS_DATA", DatabaseQueries::sensorColumn( n ) ).data(), nullptr, nullptr, nullptr );
+    }
+    sqlite3_exec( db, DatabaseQueries::index, nullptr, nullptr, nullptr );
+
+    sqlite3_stmt* insert{};
+    const auto insertQuery{DatabaseQueries::insert( sensorCount )};
+    sqlite3_prepare_v2( db, insertQuery.data(), insertQuery.size(), &insert, nullptr );
+    begin = std::chrono::steady_clock::now();
+    for ( size_t n{0}; n < samples.size(); ++n )
+    {
+        if ( n % 12 == 0 )
+        {
+            sqlite3_exec( db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr );
+        }
+        sqlite3_bind_int64( insert, 1, samples[n].time );
+        for ( uint16_t column{0}; column < columns; ++column )
+        {
+            sqlite3_bind_double( insert, 2 + column, TimeSeries::fromBits( samples[n].values[column] ) );
+        }
+        TEST_ASSERT_EQUAL( SQLITE_DONE, sqlite3_step( insert ) );
+        sqlite3_reset( insert );
+        if ( n % 12 == 11 or n == samples.size() - 1 )
+        {
+            sqlite3_exec( db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr );
+        }
+    }
+    const auto insertTime{std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - begin ).count()};
+    sqlite3_finalize( insert );
+
+    sqlite3_stmt* select{};
+    const auto selectQuery{DatabaseQueries::select( sensorCount, false, true, true, false )};
+    sqlite3_prepare_v2( db, selectQuery.data(), selectQuery.size(), &select, nullptr );
+    sqlite3_bind_int64( select, 2, samples.front().time );
+    sqlite3_bind_int64( select, 3, samples.back().time );
+    sqlite3_bind_int64( select, 6, -1 );
+    begin = std::chrono::steady_clock::now();
+    auto selected{size_t{0}};
+    while ( sqlite3_step( select ) == SQLITE_ROW )
+    {
+        for ( int column{2}; column < 2 + columns; ++column )
+        {
+            checksum ^= TimeSeries::toBits( sqlite3_column_double( select, column ) );
+        }
+        selected++;
+    }
+    const auto selectTime{std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count()};
+    sqlite3_finalize( select );
+    TEST_ASSERT_EQUAL_size_t( samples.size(), selected );
+
+    auto sqliteBytes{int64_t{0}};
+    {
+        sqlite3_stmt* pragma{};
+        sqlite3_prepare_v2( db, "SELECT page_count * page_size FROM pragma_page_count, pragma_page_size", -1, &pragma, nullptr );
+        if ( sqlite3_step( pragma ) == SQLITE_ROW )
+        {
+            sqliteBytes = sqlite3_column_int64( pragma, 0 );
+        }
+        sqlite3_finalize( pragma );
+    }
+    sqlite3_close( db );
+
+    const auto compressedBytes{static_cast<double>( store.blocks.size() * TimeSeries::blockSize )};
+    char message[200];
+    std::snprintf( message, sizeof( message ), "bytes per sample: compressed %.1f, sqlite %.1f", compressedBytes / samples.size(), static_cast<double>( sqliteBytes ) / samples.size() );
+    TEST_MESSAGE( message );
+    std::snprintf( message, sizeof( message ), "append per sample: compressed %.2f us, sqlite %.2f us", encodeTime / samples.size(), insertTime / samples.size() );
+    TEST_MESSAGE( message );
+    std::snprintf( message, sizeof( message ), "year scan: compressed %.0f samples/s, sqlite %.0f samples/s (checksum %llx)",
+                   decoded / decodeTime, selected / selectTime, static_cast<unsigned long long>( checksum ) );
+    TEST_MESSAGE( message );
+
+    TEST_ASSERT_LESS_THAN( sqliteBytes, compressedBytes );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_round_trip_is_bit_exact );
+    RUN_TEST( test_sensor_count_change_closes_block );
+    RUN_TEST( test_benchmark_against_sqlite );
+    return UNITY_END();
+}
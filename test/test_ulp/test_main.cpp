@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <array>
+#include <esp32/ulp.h>
+
+#include <Sampling.hpp>
+#include <Ulp.hpp>
+
+// Runs the ULP program Ulp::load() builds on the emulator of test/support/esp32/ulp.h. Ulp.cpp is compiled into
+// this test only, the channel map normally comes from Sampling.cpp and is provided here.
+#include <Ulp.cpp>
+
+static constexpr std::array<adc1_channel_t, Sampling::channelsCount> channels{ADC1_CHANNEL_5, ADC1_CHANNEL_4, ADC1_CHANNEL_7};
+
+auto Sampling::channel( uint8_t index ) -> adc1_channel_t
+{
+    return channels[index];
+}
+
+static auto levels( uint16_t first, uint16_t second, uint16_t third ) -> void
+{
+    Host::adc()[channels[0]] = first;
+    Host::adc()[channels[1]] = second;
+    Host::adc()[channels[2]] = third;
+}
+
+static auto noAlarm{std::array<uint16_t, Sampling::channelsCount> {0, 0, 0}};
+
+void setUp()
+{
+    Host::ulp() = Host::Ulp{};
+    Host::rtcSlowMemory().fill( 0 );
+    levels( 0, 0, 0 );
+}
+
+void tearDown()
+{
+}
+
+static void test_program_fits_the_reserved_memory()
+{
+    Ulp::start( noAlarm, std::chrono::milliseconds( 1000 ), 10 );
+    TEST_ASSERT_LESS_OR_EQUAL( 512 / 4, Ulp::programOffset + Host::ulp().program.size() );
+    TEST_ASSERT_EQUAL_UINT32( 1000000, Host::ulp().period );
+    TEST_ASSERT_TRUE( Host::ulpWakeup() );
+}
+
+static void test_batch_accumulates_and_wakes()
+{
+    static constexpr uint16_t batch{5};
+    static constexpr uint16_t readings[batch][3]{{1000, 0, 4095}, {1200, 10, 4000}, {800, 5, 4095}, {1100, 20, 3000}, {900, 15, 3500}};
+
+    Ulp::start( noAlarm, std::chrono::milliseconds( 1000 ), batch );
+    for ( uint16_t n{0}; n < batch; ++n )
+    {
+        levels( readings[n][0], readings[n][1], readings[n][2] );
+        TEST_ASSERT_TRUE( Host::ulpTick() );
+        TEST_ASSERT_EQUAL_UINT16( n + 1, Ulp::count() );
+        TEST_ASSERT_EQUAL_UINT32( n + 1 == batch ? 1 : 0, Host::ulp().wakes );
+    }
+
+    for ( uint8_t channel{0}; channel < Sampling::channelsCount; ++channel )
+    {
+        auto min{uint16_t{0xFFFF}};
+        auto max{uint16_t{0}};
+        auto sum{uint32_t{0}};
+        for ( const auto& reading : readings )
+        {
+            min = std::min( min, reading[channel] );
+            max = std::max( max, reading[channel] );
+            sum += reading[channel];
+        }
+        const auto accumulator{Ulp::get( channel )};
+        TEST_ASSERT_EQUAL_UINT16( min, accumulator.min );
+        TEST_ASSERT_EQUAL_UINT16( max, accumulator.max );
+        TEST_ASSERT_EQUAL_UINT32( sum, accumulator.sum );
+    }
+    TEST_ASSERT_FALSE( Ulp::alarmed() );
+
+    // The timer stays off until the main CPU restarts the batch
+    TEST_ASSERT_FALSE( Host::ulpTick() );
+    Ulp::restart();
+    levels( 2000, 2000, 2000 );
+    TEST_ASSERT_TRUE( Host::ulpTick() );
+    TEST_ASSERT_EQUAL_UINT16( 1, Ulp::count() );
+    TEST_ASSERT_EQUAL_UINT16( 2000, Ulp::get( 0 ).min );
+    TEST_ASSERT_EQUAL_UINT32( 2000, Ulp::get( 0 ).sum );
+}
+
+static void test_sum_carries_into_the_high_word()
+{
+    static constexpr uint16_t batch{100};
+    Ulp::start( noAlarm, std::chrono::milliseconds( 1000 ), batch );
+    levels( 4095, 1, 3000 );
+    for ( uint16_t n{0}; n < batch; ++n )
+    {
+        Host::ulpTick();
+    }
+    TEST_ASSERT_EQUAL_UINT32( 1, Host::ulp().wakes );
+    TEST_ASSERT_EQUAL_UINT32( 409500, Ulp::get( 0 ).sum );
+    TEST_ASSERT_EQUAL_UINT32( 100, Ulp::get( 1 ).sum );
+    TEST_ASSERT_EQUAL_UINT32( 300000, Ulp::get( 2 ).sum );
+}
+
+// The longest log interval the configuration accepts is a full 16 bit batch of one second readings
+static void test_largest_batch_wakes_once_at_the_end()
+{
+    static constexpr uint16_t batch{0xFFFF};
+    Ulp::start( noAlarm, std::chrono::milliseconds( 1000 ), batch );
+    levels( 4095, 0, 1 );
+    for ( uint32_t n{1}; n < batch; ++n )
+    {
+        Host::ulpTick();
+    }
+    TEST_ASSERT_EQUAL_UINT32( 0, Host::ulp().wakes );
+    TEST_ASSERT_EQUAL_UINT16( batch - 1, Ulp::count() );
+
+    TEST_ASSERT_TRUE( Host::ulpTick() );
+    TEST_ASSERT_EQUAL_UINT32( 1, Host::ulp().wakes );
+    TEST_ASSERT_EQUAL_UINT16( batch, Ulp::count() );
+    TEST_ASSERT_EQUAL_UINT32( uint32_t{4095} * batch, Ulp::get( 0 ).sum );
+    TEST_ASSERT_EQUAL_UINT32( 0, Ulp::get( 1 ).sum );
+    TEST_ASSERT_EQUAL_UINT32( batch, Ulp::get( 2 ).sum );
+    TEST_ASSERT_FALSE( Host::ulpTick() );
+}
+
+static void test_threshold_wakes_at_once()
+{
+    Ulp::start( {0, 1500, 0}, std::chrono::milliseconds( 1000 ), 100 );
+
+    // Channels without a threshold never alarm, even at 0
+    levels( 0, 1600, 0 );
+    TEST_ASSERT_TRUE( Host::ulpTick() );
+    levels( 0, 1500, 0 );
+    TEST_ASSERT_TRUE( Host::ulpTick() );
+    TEST_ASSERT_EQUAL_UINT32( 0, Host::ulp().wakes );
+    TEST_ASSERT_FALSE( Ulp::alarmed() );
+
+    levels( 0, 1499, 0 );
+    TEST_ASSERT_TRUE( Host::ulpTick() );
+    TEST_ASSERT_EQUAL_UINT32( 1, Host::ulp().wakes );
+    TEST_ASSERT_TRUE( Ulp::alarmed() );
+    TEST_ASSERT_EQUAL_UINT16( 1499, Ulp::get( 1 ).min );
+    // The alarm leaves before the sample is counted
+    TEST_ASSERT_EQUAL_UINT16( 2, Ulp::count() );
+    TEST_ASSERT_FALSE( Host::ulpTick() );
+}
+
+// A drain boot arms the ULP before any reading is published, the empty snapshot must not read as a tank in alarm
+static void test_threshold_without_a_reading_keeps_the_previous_one()
+{
+    TEST_ASSERT_EQUAL_UINT16( 1500, Ulp::threshold( 1500, Ulp::unknown, 1500 ) );
+    TEST_ASSERT_EQUAL_UINT16( 0, Ulp::threshold( 1500, Ulp::unknown, 0 ) );
+
+    TEST_ASSERT_EQUAL_UINT16( 1500, Ulp::threshold( 1500, 1500, 0 ) );
+    TEST_ASSERT_EQUAL_UINT16( 1500, Ulp::threshold( 1500, 4095, 0 ) );
+    // Already below the level, quiet until the next day
+    TEST_ASSERT_EQUAL_UINT16( 0, Ulp::threshold( 1500, 1499, 1500 ) );
+    TEST_ASSERT_EQUAL_UINT16( 0, Ulp::threshold( 1500, 0, 1500 ) );
+}
+
+auto main() -> int
+{
+    UNITY_BEGIN();
+    RUN_TEST( test_program_fits_the_reserved_memory );
+    RUN_TEST( test_batch_accumulates_and_wakes );
+    RUN_TEST( test_sum_carries_into_the_high_word );
+    RUN_TEST( test_largest_batch_wakes_once_at_the_end );
+    RUN_TEST( test_threshold_wakes_at_once );
+    RUN_TEST( test_threshold_without_a_reading_keeps_the_previous_one );
+    return UNITY_END();
+}